@@ -21,15 +21,37 @@
 
 Arguments::Arguments() :
 	_palette(-1)
+{
+	addOptions();
+	_parser.process(*qApp);
+	parse();
+}
+
+/*
+ * Parses arguments without exiting on error,
+ * the first argument is the program name.
+ */
+Arguments::Arguments(const QStringList &arguments) :
+	_palette(-1)
+{
+	addOptions();
+	if (_parser.parse(arguments)) {
+		parse();
+	} else {
+		_errorText = _parser.errorText();
+	}
+}
+
+void Arguments::addOptions()
 {
 	_parser.addHelpOption();
 	_parser.addVersionOption();
 	
 	TIM_ADD_ARGUMENT(TIM_OPTION_NAMES("if", "input-format"),
-	                 "Input format (*tim*, tex, png, jpg, bmp).",
+	                 "Input format (*tim*, tex, png, jpg, bmp, raw).",
 	                 "input-format", "");
 	TIM_ADD_ARGUMENT(TIM_OPTION_NAMES("of", "output-format"),
-	                 "Output format (tim, tex, *png*, jpg, bmp).",
+	                 "Output format (tim, tex, *png*, jpg, bmp, raw).",
 	                 "output-format", "png");
 	TIM_ADD_ARGUMENT(TIM_OPTION_NAMES("p", "palette"),
 	                 "If the input format is a texture: Select the palette to extract.",
@@ -48,11 +70,60 @@ Arguments::Arguments() :
 	                 "Alias for --ep --em.");
 	TIM_ADD_FLAG(TIM_OPTION_NAMES("a", "analysis"),
 	             "Analysis mode, search TIM files into the input file.");
+	TIM_ADD_FLAG("dedupe",
+	             "Analysis mode: export only the first copy of identical TIM files.");
+	TIM_ADD_FLAG("hard-link",
+	             "With --dedupe: hard link duplicates to the files of the first copy.");
+	TIM_ADD_FLAG("vram",
+	             "Analysis mode: load the TIM files at their positions in a 1024x512 VRAM, and save it as PNG.");
+	TIM_ADD_ARGUMENT("vram-page",
+	                 "With --vram: save this texture page, can be repeated (page number 0-31, depth 4, 8 or 16, and CLUT position).",
+	                 "page,depth,clutX,clutY", "");
+	TIM_ADD_FLAG("pack-vram",
+	             "TIM output: choose the image and palette positions in VRAM of all the outputs, without overlap.");
+	TIM_ADD_ARGUMENT("pack-vram-area",
+	                 "With --pack-vram: VRAM area to use, in 16-bit words.",
+	                 "x,y,width,height", "0,0,1024,512");
+	TIM_ADD_ARGUMENT("png-profile",
+	                 "PNG encoding: default, fast (low compression) or store (no compression).",
+	                 "profile", "default");
+	TIM_ADD_ARGUMENT("atlas",
+	                 "Export every palette in one image: index (the image once and the palette sheet) or tiles (one tile per palette), with a manifest.",
+	                 "mode", "");
+	TIM_ADD_ARGUMENT("raw-align",
+	                 "Raw output: alignment of the sections, in bytes.",
+	                 "alignment", "16");
+	TIM_ADD_ARGUMENT("raw-concat",
+	                 "Raw output: write all the textures in this file.",
+	                 "raw-concat", "");
+	TIM_ADD_FLAG("shrink-palettes",
+	             "Use 4-bit indexes when 16 colors are enough, and remove duplicated palettes of output textures.");
+	TIM_ADD_FLAG("verify-roundtrip",
+	             "Open and save every input texture in memory, report the differences with the original files and the speed.");
+	TIM_ADD_ARGUMENT("stats",
+	                 "Save the time, bytes and pixels of each stage in this file at exit (Prometheus text format if it ends with .prom, JSON otherwise).",
+	                 "stats", "");
+	TIM_ADD_ARGUMENT("trace",
+	                 "Save a timeline of the threads in this file at exit (Chrome trace format, for about:tracing or Perfetto).",
+	                 "trace", "");
+	TIM_ADD_ARGUMENT("build-db",
+	                 "Incremental mode: skip the inputs whose outputs are up to date, according to this database file.",
+	                 "build-db", "");
+	TIM_ADD_ARGUMENT("daemon",
+	                 "Daemon mode: listen to this local socket for jobs (one JSON object per line).",
+	                 "socket", "");
+	TIM_ADD_ARGUMENT("threads",
+	                 "Number of worker threads (default: number of CPU cores).",
+	                 "threads", "0");
+	TIM_ADD_ARGUMENT("jobs-file",
+	                 "Run the jobs listed in this file, one command line per line.",
+	                 "jobs-file", "");
+	TIM_ADD_ARGUMENT("cache-size",
+	                 "Daemon and jobs file modes: memory used to keep opened textures, in MiB (0 to disable).",
+	                 "cache-size", "128");
 
 	_parser.addPositionalArgument("files", QCoreApplication::translate("Arguments", "Input files."), "[files...]");
 	_parser.addPositionalArgument("directory", QCoreApplication::translate("Arguments", "Output directory."), "[directory]");
-
-	parse();
 }
 
 QStringList Arguments::paths() const
@@ -77,7 +148,7 @@ QString Arguments::outputFormat() const
 	return _parser.value("output-format");
 }
 
-QString Arguments::destinationPath(const QString &source, const QString &format, int num, int palette) const
+QString Arguments::destinationPrefix(const QString &source, int num) const
 {
 	QString destPath,
 	        sourceFilename = source.mid(source.lastIndexOf('/') + 1);
@@ -92,6 +163,13 @@ QString Arguments::destinationPath(const QString &source, const QString &format,
 		destPath.append(QString(".%1").arg(num));
 	}
 
+	return destPath;
+}
+
+QString Arguments::destinationPath(const QString &source, const QString &format, int num, int palette) const
+{
+	QString destPath = destinationPrefix(source, num);
+
 	if (palette >= 0) {
 		destPath.append(QString(".%1").arg(palette));
 	}
@@ -114,6 +192,28 @@ QString Arguments::destinationPalette(const QString &source, int num) const
 	return destinationPath(source, "palette." + outputFormat(), num);
 }
 
+QString Arguments::destinationAtlas(const QString &source, int num) const
+{
+	return destinationPath(source, "atlas", num);
+}
+
+QString Arguments::destinationDuplicates(const QString &source) const
+{
+	return destinationPath(source, "duplicates");
+}
+
+QString Arguments::destinationVram(const QString &source) const
+{
+	return destinationPath(source, "vram.png");
+}
+
+QString Arguments::destinationVramPage(const QString &source, const VramPage &page) const
+{
+	return destinationPath(source, QString("vram.page%1.%2bpp.%3x%4.png")
+	                       .arg(page.page).arg(page.depth)
+	                       .arg(page.clutX).arg(page.clutY));
+}
+
 QString Arguments::searchRelatedFile(const QString &inputPathImage, const QString &extension) const
 {
 	int indexInputExtension;
@@ -178,11 +278,193 @@ bool Arguments::analysis() const
 	return _parser.isSet("analysis");
 }
 
-void Arguments::parse()
+bool Arguments::dedupe() const
+{
+	return _parser.isSet("dedupe");
+}
+
+bool Arguments::hardLink() const
+{
+	return _parser.isSet("hard-link");
+}
+
+bool Arguments::shrinkPalettes() const
+{
+	return _parser.isSet("shrink-palettes");
+}
+
+/*
+ * Quality for QImageWriter, the PNG plugin maps [0, 100]
+ * to the zlib compression levels [9, 0].
+ */
+int Arguments::pngQuality() const
+{
+	const QString profile = _parser.value("png-profile");
+
+	if (profile.compare("fast", Qt::CaseInsensitive) == 0) {
+		return 89; // Level 1
+	} else if (profile.compare("store", Qt::CaseInsensitive) == 0) {
+		return 100; // Level 0
+	}
+
+	return -1; // Default level
+}
+
+QString Arguments::atlas() const
+{
+	return _parser.value("atlas").toLower();
+}
+
+quint32 Arguments::rawAlignment() const
 {
 	bool ok;
+	quint32 alignment = _parser.value("raw-align").toUInt(&ok);
+	if (!ok || alignment == 0) {
+		return 16;
+	}
+	return alignment;
+}
 
-	_parser.process(*qApp);
+QString Arguments::rawConcat() const
+{
+	return _parser.value("raw-concat");
+}
+
+bool Arguments::vram() const
+{
+	return _parser.isSet("vram");
+}
+
+QList<VramPage> Arguments::vramPages() const
+{
+	QList<VramPage> pages;
+
+	foreach (const QString &value, _parser.values("vram-page")) {
+		QStringList fields = value.split(',');
+		VramPage page;
+		bool ok[4] = {false, false, false, false};
+
+		if (fields.size() == 4) {
+			page.page = fields.at(0).toInt(&ok[0]);
+			page.depth = fields.at(1).toInt(&ok[1]);
+			page.clutX = fields.at(2).toInt(&ok[2]);
+			page.clutY = fields.at(3).toInt(&ok[3]);
+		}
+
+		if (ok[0] && ok[1] && ok[2] && ok[3]) {
+			pages.append(page);
+		} else {
+			qWarning() << "Warning: Invalid VRAM page" << value;
+		}
+	}
+
+	return pages;
+}
+
+bool Arguments::packVram() const
+{
+	return _parser.isSet("pack-vram");
+}
+
+QRect Arguments::packVramArea() const
+{
+	QStringList fields = _parser.value("pack-vram-area").split(',');
+	int values[4];
+
+	if (fields.size() != 4) {
+		return QRect(0, 0, 1024, 512);
+	}
+
+	for (int i = 0; i < 4; ++i) {
+		bool ok;
+		values[i] = fields.at(i).toInt(&ok);
+		if (!ok || values[i] < 0) {
+			return QRect(0, 0, 1024, 512);
+		}
+	}
+
+	return QRect(values[0], values[1], values[2], values[3]);
+}
+
+bool Arguments::verifyRoundTrip() const
+{
+	return _parser.isSet("verify-roundtrip");
+}
+
+QString Arguments::stats() const
+{
+	return _parser.value("stats");
+}
+
+QString Arguments::trace() const
+{
+	return _parser.value("trace");
+}
+
+QString Arguments::buildDatabase() const
+{
+	return _parser.value("build-db");
+}
+
+/*
+ * Options affecting the outputs, as a single string.
+ */
+QString Arguments::optionsFingerprint() const
+{
+	QStringList ret;
+
+	// Options without effect on the outputs
+	const QStringList ignored = QStringList() << "build-db" << "daemon" << "threads"
+	                                          << "cache-size" << "jobs-file" << "stats"
+	                                          << "trace";
+
+	foreach (const QString &name, _optionNames) {
+		if (ignored.contains(name)) {
+			continue;
+		}
+		if (_parser.isSet(name)) {
+			ret << QString("%1=%2").arg(name, _parser.values(name).join(","));
+		}
+	}
+
+	ret << QString("directory=%1").arg(_directory);
+
+	return ret.join(" ");
+}
+
+QString Arguments::daemon() const
+{
+	return _parser.value("daemon");
+}
+
+int Arguments::threads() const
+{
+	bool ok;
+	int threads = _parser.value("threads").toInt(&ok);
+	if (!ok || threads < 0) {
+		return 0;
+	}
+	return threads;
+}
+
+qint64 Arguments::cacheSize() const
+{
+	bool ok;
+	qint64 cacheSize = _parser.value("cache-size").toLongLong(&ok);
+	if (!ok || cacheSize < 0) {
+		return 0;
+	}
+	return cacheSize * 1024 * 1024;
+}
+
+QString Arguments::jobsFile() const
+{
+	return _parser.value("jobs-file");
+}
+
+void Arguments::parse()
+{
+	bool ok;
 
 	wilcardParse();
 
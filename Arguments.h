@@ -18,23 +18,45 @@
 #define ARGUMENTS_H
 
 #include <QCommandLineParser>
+#include <QRect>
 
 #define TIM_ADD_ARGUMENT(names, description, valueName, defaultValue) \
-	_parser.addOption(QCommandLineOption(names, description, valueName, defaultValue));
+	do { \
+		_parser.addOption(QCommandLineOption(names, description, valueName, defaultValue)); \
+		_optionNames.append(QStringList(names).last()); \
+	} while (0)
 
 #define TIM_ADD_FLAG(names, description) \
-	_parser.addOption(QCommandLineOption(names, description));
+	do { \
+		_parser.addOption(QCommandLineOption(names, description)); \
+		_optionNames.append(QStringList(names).last()); \
+	} while (0)
 
 #define TIM_OPTION_NAMES(shortName, fullName) \
 	(QStringList() << shortName << fullName)
 
+/*
+ * Texture page to export from the VRAM, see Vram::texturePage().
+ */
+struct VramPage
+{
+	int page, depth, clutX, clutY;
+};
+
 class Arguments
 {
 public:
 	Arguments();
+	explicit Arguments(const QStringList &arguments);
 	inline void showHelp(int exitCode = 0) {
 		_parser.showHelp(exitCode);
 	}
+	inline bool isValid() const {
+		return _errorText.isEmpty();
+	}
+	inline const QString &errorText() const {
+		return _errorText;
+	}
 
 	QStringList paths() const;
 	QString inputFormat(const QString &path = QString()) const;
@@ -42,6 +64,11 @@ public:
 	QString destination(const QString &source, int num = -1, int palette = -1) const;
 	QString destinationMeta(const QString &source, int num = -1) const;
 	QString destinationPalette(const QString &source, int num = -1) const;
+	QString destinationAtlas(const QString &source, int num = -1) const;
+	QString destinationDuplicates(const QString &source) const;
+	QString destinationVram(const QString &source) const;
+	QString destinationVramPage(const QString &source, const VramPage &page) const;
+	QString destinationPrefix(const QString &source, int num = -1) const;
 	QString inputPathPalette(const QString &inputPathImage) const;
 	QString inputPathMeta(const QString &inputPathImage) const;
 	bool exportPalettes() const;
@@ -49,15 +76,36 @@ public:
 	bool help() const;
 	int palette() const;
 	bool analysis() const;
+	bool dedupe() const;
+	bool hardLink() const;
+	bool shrinkPalettes() const;
+	int pngQuality() const;
+	QString atlas() const;
+	quint32 rawAlignment() const;
+	QString rawConcat() const;
+	bool vram() const;
+	QList<VramPage> vramPages() const;
+	bool packVram() const;
+	QRect packVramArea() const;
+	bool verifyRoundTrip() const;
+	QString stats() const;
+	QString trace() const;
+	QString buildDatabase() const;
+	QString optionsFingerprint() const;
+	QString daemon() const;
+	int threads() const;
+	qint64 cacheSize() const;
+	QString jobsFile() const;
 private:
 	bool exportAll() const;
+	void addOptions();
 	void parse();
 	void wilcardParse();
 	static QStringList searchFiles(const QString &path);
 	QString destinationPath(const QString &source, const QString &format, int num = -1, int palette = -1) const;
 	QString searchRelatedFile(const QString &inputPathImage, const QString &extension) const;
-	QStringList _paths;
-	QString _directory;
+	QStringList _paths, _optionNames;
+	QString _directory, _errorText;
 	int _palette;
 	QCommandLineParser _parser;
 };
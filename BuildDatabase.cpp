@@ -0,0 +1,219 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "BuildDatabase.h"
+#include "Hash.h"
+
+#define BUILD_DATABASE_MAGIC	"# Vincent Tim build database 1"
+
+BuildDatabase::BuildDatabase(const QString &filename) :
+	_filename(filename)
+{
+}
+
+/*
+ * File format, one record per line, fields separated by tabs:
+ * I <input> <options>
+ * D <dependency> <size> <mtime> <hash>
+ * O <output>
+ */
+bool BuildDatabase::open()
+{
+	QFile f(_filename);
+
+	_entries.clear();
+
+	if (!f.exists()) {
+		return true; // First build
+	}
+
+	if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return false;
+	}
+
+	if (f.readLine().trimmed() != BUILD_DATABASE_MAGIC) {
+		qWarning() << "BuildDatabase::open unknown format, ignored" << _filename;
+		return true;
+	}
+
+	Entry *entry = 0;
+
+	while (!f.atEnd()) {
+		QString line = QString::fromUtf8(f.readLine());
+		line.chop(1); // \n
+		QStringList cols = line.split('\t');
+
+		if (cols.first() == "I" && cols.size() == 3) {
+			entry = &_entries[cols.at(1)];
+			*entry = Entry();
+			entry->options = cols.at(2);
+		} else if (entry && cols.first() == "D" && cols.size() == 5) {
+			Fingerprint fp;
+			fp.size = cols.at(2).toLongLong();
+			fp.mtime = cols.at(3).toLongLong();
+			fp.hash = cols.at(4).toULongLong(0, 16);
+			entry->dependencies.insert(cols.at(1), fp);
+		} else if (entry && cols.first() == "O" && cols.size() == 2) {
+			entry->outputs.append(cols.at(1));
+		} else if (!line.isEmpty()) {
+			qWarning() << "BuildDatabase::open invalid line" << line;
+			_entries.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool BuildDatabase::save() const
+{
+	QSaveFile f(_filename);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		return false;
+	}
+
+	f.write(BUILD_DATABASE_MAGIC "\n");
+
+	QHashIterator<QString, Entry> it(_entries);
+	while (it.hasNext()) {
+		it.next();
+		const Entry &entry = it.value();
+
+		f.write(QString("I\t%1\t%2\n").arg(it.key(), entry.options).toUtf8());
+
+		QMapIterator<QString, Fingerprint> itDep(entry.dependencies);
+		while (itDep.hasNext()) {
+			itDep.next();
+			const Fingerprint &fp = itDep.value();
+			f.write(QString("D\t%1\t%2\t%3\t%4\n")
+			        .arg(itDep.key())
+			        .arg(fp.size)
+			        .arg(fp.mtime)
+			        .arg(Hash::toHex(fp.hash))
+			        .toUtf8());
+		}
+
+		foreach (const QString &output, entry.outputs) {
+			f.write(QString("O\t%1\n").arg(output).toUtf8());
+		}
+	}
+
+	return f.commit();
+}
+
+bool BuildDatabase::isUpToDate(const QString &input, const QStringList &dependencies,
+                               const QString &options)
+{
+	QHash<QString, Entry>::iterator it = _entries.find(input);
+	if (it == _entries.end()) {
+		return false;
+	}
+
+	Entry &entry = it.value();
+
+	if (entry.options != options
+	        || entry.dependencies.size() != dependencies.size()) {
+		return false;
+	}
+
+	foreach (const QString &output, entry.outputs) {
+		if (!QFile::exists(output)) {
+			return false;
+		}
+	}
+
+	foreach (const QString &dependency, dependencies) {
+		QMap<QString, Fingerprint>::iterator itDep = entry.dependencies.find(dependency);
+		if (itDep == entry.dependencies.end()) {
+			return false;
+		}
+
+		Fingerprint &stored = itDep.value();
+		Fingerprint current = fingerprint(dependency, false);
+
+		if (current.size != stored.size) {
+			return false;
+		}
+
+		if (current.mtime != stored.mtime) {
+			// Touched but maybe not modified
+			if (!hashFile(dependency, current.hash) || current.hash != stored.hash) {
+				return false;
+			}
+			stored.mtime = current.mtime;
+		}
+	}
+
+	return true;
+}
+
+QStringList BuildDatabase::outputs(const QString &input) const
+{
+	return _entries.value(input).outputs;
+}
+
+void BuildDatabase::update(const QString &input, const QStringList &dependencies,
+                           const QString &options, const QStringList &outputs)
+{
+	Entry entry;
+	entry.options = options;
+	entry.outputs = outputs;
+
+	foreach (const QString &dependency, dependencies) {
+		entry.dependencies.insert(dependency, fingerprint(dependency, true));
+	}
+
+	_entries.insert(input, entry);
+}
+
+BuildDatabase::Fingerprint BuildDatabase::fingerprint(const QString &path, bool withHash)
+{
+	Fingerprint fp;
+	QFileInfo info(path);
+
+	if (info.exists()) {
+		fp.size = info.size();
+		fp.mtime = info.lastModified().toMSecsSinceEpoch();
+		if (withHash) {
+			hashFile(path, fp.hash);
+		}
+	}
+
+	return fp;
+}
+
+bool BuildDatabase::hashFile(const QString &path, quint64 &hash)
+{
+	QFile f(path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	if (f.size() == 0) {
+		hash = Hash::xxh64(QByteArray());
+		return true;
+	}
+
+	const uchar *data = f.map(0, f.size());
+	if (data) {
+		hash = Hash::xxh64((const char *)data, f.size());
+		f.unmap((uchar *)data);
+	} else {
+		hash = Hash::xxh64(f.readAll());
+	}
+
+	return true;
+}
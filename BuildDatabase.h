@@ -0,0 +1,55 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef BUILDDATABASE_H
+#define BUILDDATABASE_H
+
+#include <QtCore>
+
+/*
+ * Remembers, for each input file, the fingerprints of the files
+ * used to build the outputs and the options used.
+ */
+class BuildDatabase
+{
+public:
+	explicit BuildDatabase(const QString &filename);
+	bool open();
+	bool save() const;
+	bool isUpToDate(const QString &input, const QStringList &dependencies,
+	                const QString &options);
+	QStringList outputs(const QString &input) const;
+	void update(const QString &input, const QStringList &dependencies,
+	            const QString &options, const QStringList &outputs);
+private:
+	struct Fingerprint {
+		Fingerprint() : size(-1), mtime(-1), hash(0) {}
+		qint64 size, mtime;
+		quint64 hash;
+	};
+	struct Entry {
+		QString options;
+		QMap<QString, Fingerprint> dependencies;
+		QStringList outputs;
+	};
+	static Fingerprint fingerprint(const QString &path, bool withHash);
+	static bool hashFile(const QString &path, quint64 &hash);
+
+	QString _filename;
+	QHash<QString, Entry> _entries;
+};
+
+#endif // BUILDDATABASE_H
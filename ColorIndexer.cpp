@@ -0,0 +1,105 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ColorIndexer.h"
+#include <climits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+ColorIndexer::ColorIndexer(const QVector<QRgb> &colorTable) :
+	_colorTable(colorTable)
+{
+	int bits = 4;
+
+	// At least one empty slot, and short probe sequences
+	while ((1 << bits) < colorTable.size() * 2) {
+		++bits;
+	}
+
+	_mask = (1u << bits) - 1;
+	_shift = 32 - bits;
+	_keys.fill(0, 1 << bits);
+	_indexes.fill(-1, 1 << bits);
+
+	for (int i = 0; i < colorTable.size(); ++i) {
+		const QRgb color = colorTable.at(i);
+		quint32 slot = hashSlot(color);
+
+		while (_indexes.at(slot) >= 0 && _keys.at(slot) != color) {
+			slot = (slot + 1) & _mask;
+		}
+
+		// The first index wins when a color is repeated
+		if (_indexes.at(slot) < 0) {
+			_keys[slot] = color;
+			_indexes[slot] = qint16(i);
+		}
+	}
+}
+
+int ColorIndexer::distance(QRgb color1, QRgb color2)
+{
+	return qAbs(qRed(color1) - qRed(color2))
+	        + qAbs(qGreen(color1) - qGreen(color2))
+	        + qAbs(qBlue(color1) - qBlue(color2))
+	        + qAbs(qAlpha(color1) - qAlpha(color2));
+}
+
+/*
+ * Same result as QImage::convertToFormat(Format_Indexed8, colorTable):
+ * the first color with the lowest sum of channel differences.
+ */
+int ColorIndexer::nearestIndex(QRgb color) const
+{
+	const QRgb *colors = _colorTable.constData();
+	const int count = _colorTable.size();
+	int best = 0, bestDistance = INT_MAX, i = 0;
+
+#ifdef __SSE2__
+	const __m128i pixel = _mm_set1_epi32(int(color)),
+	        lowBytes = _mm_set1_epi16(0x00FF),
+	        lowWords = _mm_set1_epi32(0xFFFF);
+
+	// Four colors at a time
+	for (; i + 4 <= count; i += 4) {
+		__m128i c = _mm_loadu_si128((const __m128i *)(colors + i));
+		__m128i diff = _mm_or_si128(_mm_subs_epu8(c, pixel), _mm_subs_epu8(pixel, c));
+		__m128i sum16 = _mm_add_epi16(_mm_and_si128(diff, lowBytes), _mm_srli_epi16(diff, 8));
+		__m128i sum32 = _mm_add_epi32(_mm_and_si128(sum16, lowWords), _mm_srli_epi32(sum16, 16));
+		int distances[4];
+
+		_mm_storeu_si128((__m128i *)distances, sum32);
+
+		for (int j = 0; j < 4; ++j) {
+			if (distances[j] < bestDistance) {
+				bestDistance = distances[j];
+				best = i + j;
+			}
+		}
+	}
+#endif
+
+	for (; i < count; ++i) {
+		int d = distance(color, colors[i]);
+		if (d < bestDistance) {
+			bestDistance = d;
+			best = i;
+		}
+	}
+
+	return best;
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef COLORINDEXER_H
+#define COLORINDEXER_H
+
+#include <QVector>
+#include <QHash>
+#include <QRgb>
+
+/*
+ * Finds the index of a color in a color table:
+ * exact matches use an open addressing hash table,
+ * other colors use the nearest color (same distance as QImage).
+ */
+class ColorIndexer
+{
+public:
+	explicit ColorIndexer(const QVector<QRgb> &colorTable);
+	inline int exactIndex(QRgb color) const {
+		quint32 slot = hashSlot(color);
+		forever {
+			qint16 index = _indexes[slot];
+			if (index < 0 || _keys[slot] == color) {
+				return index;
+			}
+			slot = (slot + 1) & _mask;
+		}
+	}
+	int nearestIndex(QRgb color) const;
+	inline quint8 index(QRgb color, bool *exact) {
+		int idx = exactIndex(color);
+		if (idx >= 0) {
+			*exact = true;
+			return quint8(idx);
+		}
+		*exact = false;
+		QHash<QRgb, quint8>::const_iterator it = _nearestCache.constFind(color);
+		if (it != _nearestCache.constEnd()) {
+			return it.value();
+		}
+		quint8 nearest = quint8(nearestIndex(color));
+		_nearestCache.insert(color, nearest);
+		return nearest;
+	}
+	static int distance(QRgb color1, QRgb color2);
+private:
+	inline quint32 hashSlot(QRgb color) const {
+		return (quint32(color) * 0x9E3779B1u) >> _shift;
+	}
+
+	QVector<QRgb> _colorTable;
+	QVector<QRgb> _keys;
+	QVector<qint16> _indexes;
+	quint32 _mask;
+	int _shift;
+	QHash<QRgb, quint8> _nearestCache;
+};
+
+#endif // COLORINDEXER_H
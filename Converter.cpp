@@ -0,0 +1,861 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Converter.h"
+#include <QImageWriter>
+#include <QtMath>
+#include "TimFile.h"
+#include "TexFile.h"
+#include "TextureImageFile.h"
+#include "TextureRawFile.h"
+#include "Deduplicator.h"
+#include "Hash.h"
+#include "BuildDatabase.h"
+#include "TextureCache.h"
+#include "Transcoder.h"
+#include "Vram.h"
+#include "VramPacker.h"
+#include "Stats.h"
+#include "Trace.h"
+
+QMutex Converter::_buildDbMutexesGuard;
+QHash<QString, QMutex *> Converter::_buildDbMutexes;
+
+Converter::Converter(const Arguments &args, TextureCache *cache) :
+	_args(args), _cache(cache), _buildDb(0), _rawConcat(0), _exitCode(0)
+{
+}
+
+Converter::~Converter()
+{
+	delete _buildDb;
+	delete _rawConcat;
+	foreach (const VramTexture &texture, _vramTextures) {
+		delete texture.tim;
+	}
+}
+
+/*
+ * Two jobs using the same build database must not run concurrently.
+ * The mutexes are kept until the end of the program.
+ */
+QMutex *Converter::buildDbMutex(const QString &path)
+{
+	const QFileInfo info(path);
+	// The database does not exist before the first build
+	const QString key = info.exists() ? info.canonicalFilePath()
+	                                  : QDir::cleanPath(info.absoluteFilePath());
+	QMutexLocker locker(&_buildDbMutexesGuard);
+	QMutex *&mutex = _buildDbMutexes[key];
+
+	if (mutex == 0) {
+		mutex = new QMutex();
+	}
+
+	return mutex;
+}
+
+int Converter::exec()
+{
+	QMutexLocker locker(_args.buildDatabase().isEmpty() ? 0 : buildDbMutex(_args.buildDatabase()));
+
+	_exitCode = 0;
+
+	if (!_args.rawConcat().isEmpty()
+	        && _args.outputFormat().compare("raw", Qt::CaseInsensitive) != 0) {
+		qWarning() << "Error: --raw-concat needs the raw output format";
+		return 1;
+	}
+
+	if (!_args.rawConcat().isEmpty()) {
+		_rawConcat = new QFile(_args.rawConcat());
+		if (!_rawConcat->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(_rawConcat->fileName()) << _rawConcat->errorString();
+			return 1;
+		}
+	}
+
+	// Skipped inputs would be missing in the concatenated file or the layout
+	if (!_args.buildDatabase().isEmpty() && _rawConcat) {
+		qWarning() << "Warning: --build-db is ignored with --raw-concat";
+	} else if (!_args.buildDatabase().isEmpty() && _args.packVram()) {
+		qWarning() << "Warning: --build-db is ignored with --pack-vram";
+	} else if (!_args.buildDatabase().isEmpty()) {
+		_buildDb = new BuildDatabase(_args.buildDatabase());
+		if (!_buildDb->open()) {
+			qWarning() << "Warning: Cannot read the build database, everything will be rebuilt";
+		}
+		_options = _args.optionsFingerprint();
+	}
+
+	foreach (const QString &path, _args.paths()) {
+		if (QDir(path).exists()) {
+			qWarning() << "Directory ignored" << path;
+			continue;
+		}
+
+		if (!convert(path) && _exitCode == 0) {
+			_exitCode = 1;
+		}
+	}
+
+	if (!_vramTextures.isEmpty() && !packVram()) {
+		_exitCode = 1;
+	}
+
+	if (_rawConcat) {
+		_rawConcat->close();
+		if (_rawConcat->error() != QFile::NoError) {
+			qWarning() << "Error: Cannot save" << QDir::toNativeSeparators(_rawConcat->fileName()) << _rawConcat->errorString();
+			_exitCode = 1;
+		} else {
+			printPath(_rawConcat->fileName());
+		}
+		delete _rawConcat;
+		_rawConcat = 0;
+	}
+
+	if (_buildDb) {
+		if (!_buildDb->save()) {
+			qWarning() << "Error: Cannot save the build database";
+			_exitCode = 1;
+		}
+		delete _buildDb;
+		_buildDb = 0;
+	}
+
+	return _exitCode;
+}
+
+/*
+ * Sets the VRAM positions of the TIM files kept by toTexture(),
+ * then saves them.
+ */
+bool Converter::packVram()
+{
+	VramPacker packer(_args.packVramArea());
+	bool ok = true;
+
+	foreach (const VramTexture &texture, _vramTextures) {
+		TimFile *tim = texture.tim;
+		// Widths in 16-bit words
+		packer.addTexture(QSize(tim->image().width() * tim->depth() / 16, tim->image().height()),
+		                  tim->isPaletted() ? tim->paletteSize() : QSize());
+	}
+
+	const bool packed = packer.pack();
+
+	if (!packed) {
+		qWarning() << "Error: Textures do not fit in the VRAM area";
+		ok = false;
+	}
+
+	for (int i = 0; i < _vramTextures.size(); ++i) {
+		TimFile *tim = _vramTextures.at(i).tim;
+		const QString &destPath = _vramTextures.at(i).destPath;
+
+		if (!packed) {
+			qWarning() << "Error: Not converted, no room in VRAM" << QDir::toNativeSeparators(_vramTextures.at(i).path);
+		} else {
+			QMap<QString, QVariant> positions;
+			positions["imageX"] = packer.imagePosition(i).x();
+			positions["imageY"] = packer.imagePosition(i).y();
+			if (tim->isPaletted()) {
+				positions["paletteX"] = packer.clutPosition(i).x();
+				positions["paletteY"] = packer.clutPosition(i).y();
+			}
+			tim->setExtraData(ExtraData(positions));
+
+			if (!tim->saveToFile(destPath)) {
+				qWarning() << "Error: Cannot save Texture file" << QDir::toNativeSeparators(destPath);
+				ok = false;
+			} else {
+				printPath(destPath);
+			}
+		}
+
+		delete tim;
+	}
+
+	_vramTextures.clear();
+
+	return ok;
+}
+
+void Converter::print(const QString &text)
+{
+	printf("%s\n", qPrintable(text));
+}
+
+void Converter::printPath(const QString &path)
+{
+	print(QDir::toNativeSeparators(path));
+}
+
+bool Converter::saveImage(const QImage &image, const QString &destPath)
+{
+	QImageWriter writer(destPath);
+
+	if (QFileInfo(destPath).suffix().compare("png", Qt::CaseInsensitive) == 0) {
+		writer.setFormat("PNG");
+		writer.setQuality(_args.pngQuality());
+	}
+
+	StatsTimer timer(Stats::ImageEncode, 0, image.width() * image.height());
+	return writer.write(image);
+}
+
+bool Converter::saveTextureTo(TextureFile *texture, const QString &destPath)
+{
+	const QImage &image = texture->image();
+	bool saved;
+
+	// Paletted PNG (with alpha in tRNS), the indexes are kept
+	if (image.format() == QImage::Format_Indexed8 && image.colorCount() > 0
+	        && _args.outputFormat().compare("png", Qt::CaseInsensitive) == 0) {
+		saved = saveImage(image, destPath);
+	} else {
+		saved = saveImage(image.convertToFormat(QImage::Format_ARGB32), destPath);
+	}
+
+	if (!saved) {
+		return false;
+	}
+
+	printPath(destPath);
+	return true;
+}
+
+/*
+ * One raw file with all the palettes,
+ * or a record in the --raw-concat file.
+ */
+bool Converter::saveRawTo(TextureFile *texture, const QString &path, int num,
+                          QStringList *outputs)
+{
+	TextureRawFile raw(*texture);
+	QByteArray data;
+
+	raw.setAlignment(_args.rawAlignment());
+	raw.setName(QFileInfo(_args.destinationPrefix(path, num)).fileName());
+
+	if (!raw.save(data)) {
+		qWarning() << "Error: Cannot convert to raw" << QDir::toNativeSeparators(path);
+		return false;
+	}
+
+	StatsTimer timer(Stats::Write, data.size());
+
+	if (_rawConcat) {
+		if (_rawConcat->write(data) != data.size()) {
+			qWarning() << "Error: Cannot write" << QDir::toNativeSeparators(_rawConcat->fileName()) << _rawConcat->errorString();
+			return false;
+		}
+		return true;
+	}
+
+	const QString destPath = _args.destination(path, num);
+	QFile f(destPath);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)
+	        || f.write(data) != data.size()) {
+		qWarning() << "Error: Cannot save raw file" << QDir::toNativeSeparators(destPath) << f.errorString();
+		return false;
+	}
+
+	printPath(destPath);
+	if (outputs) {
+		outputs->append(destPath);
+	}
+
+	return true;
+}
+
+/*
+ * Every palette in one export, described by a manifest:
+ * "index" saves the image once with the palette sheet,
+ * "tiles" saves the image with each palette side by side.
+ */
+bool Converter::saveAtlasTo(TextureFile *texture, const QString &path, int num,
+                            QStringList *outputs)
+{
+	const QString mode = _args.atlas(),
+	        destPath = _args.destination(path, num);
+	const int count = texture->colorTableCount(),
+	        width = texture->image().width(),
+	        height = texture->image().height();
+	QMap<QString, QVariant> manifest;
+
+	manifest["mode"] = mode;
+	manifest["palettes"] = count;
+	manifest["width"] = width;
+	manifest["height"] = height;
+	manifest["image"] = QFileInfo(destPath).fileName();
+
+	if (mode == "index") {
+		texture->setCurrentColorTable(0);
+		if (!saveTextureTo(texture, destPath)) {
+			return false;
+		}
+		if (outputs) {
+			outputs->append(destPath);
+		}
+
+		const QString destPathPalette = _args.destinationPalette(path, num);
+		QImage palette = texture->palette();
+		if (palette.isNull() || !saveImage(palette, destPathPalette)) {
+			qWarning() << "Error: Cannot save palette";
+			return false;
+		}
+		printPath(destPathPalette);
+		if (outputs) {
+			outputs->append(destPathPalette);
+		}
+
+		manifest["palette"] = QFileInfo(destPathPalette).fileName();
+	} else if (mode == "tiles") {
+		const int columns = qCeil(qSqrt(count)),
+		        rows = (count + columns - 1) / columns;
+		QImage atlas(columns * width, rows * height, QImage::Format_ARGB32);
+
+		atlas.fill(0);
+
+		for (int paletteID = 0; paletteID < count; ++paletteID) {
+			texture->setCurrentColorTable(paletteID);
+			const QImage tile = texture->image().convertToFormat(QImage::Format_ARGB32);
+			const int x = (paletteID % columns) * width,
+			        y = (paletteID / columns) * height;
+
+			for (int line = 0; line < height; ++line) {
+				memcpy(atlas.scanLine(y + line) + x * 4, tile.constScanLine(line), width * 4);
+			}
+		}
+
+		if (!saveImage(atlas, destPath)) {
+			return false;
+		}
+		printPath(destPath);
+		if (outputs) {
+			outputs->append(destPath);
+		}
+
+		manifest["columns"] = columns;
+	} else {
+		qWarning() << "Error: Unknown atlas mode" << mode;
+		return false;
+	}
+
+	const QString destPathAtlas = _args.destinationAtlas(path, num);
+	if (!ExtraData(manifest).save(destPathAtlas)) {
+		qWarning() << "Error: Cannot save atlas manifest";
+		return false;
+	}
+	printPath(destPathAtlas);
+	if (outputs) {
+		outputs->append(destPathAtlas);
+	}
+
+	return true;
+}
+
+bool Converter::fromTexture(TextureFile *texture, const QString &path, int num,
+                            QStringList *outputs)
+{
+	QString destPathTexture;
+	const bool raw = _args.outputFormat().compare("raw", Qt::CaseInsensitive) == 0,
+	        atlas = !raw && !_args.atlas().isEmpty() && texture->colorTableCount() > 0;
+	bool error = false;
+
+	if (raw) {
+		error = !saveRawTo(texture, path, num, outputs);
+	} else if (atlas) {
+		error = !saveAtlasTo(texture, path, num, outputs);
+	} else if (_args.palette() < 0 || _args.palette() >= texture->colorTableCount()) {
+		if (texture->colorTableCount() <= 0) {
+			destPathTexture = _args.destination(path, num);
+			if (!saveTextureTo(texture, destPathTexture)) {
+				error = true;
+			} else if (outputs) {
+				outputs->append(destPathTexture);
+			}
+		}
+
+		for (int paletteID=0; paletteID<texture->colorTableCount(); ++paletteID) {
+			TraceSpan span("palette", Trace::isEnabled() ? QString::number(paletteID) : QString());
+			texture->setCurrentColorTable(paletteID);
+			destPathTexture = _args.destination(path, num, paletteID);
+			if (!saveTextureTo(texture, destPathTexture)) {
+				error = true;
+			} else if (outputs) {
+				outputs->append(destPathTexture);
+			}
+		}
+	} else {
+		destPathTexture = _args.destination(path, num);
+		if (!saveTextureTo(texture, destPathTexture)) {
+			error = true;
+		} else if (outputs) {
+			outputs->append(destPathTexture);
+		}
+	}
+
+	if (!error) {
+		if (_args.exportMeta()) {
+			ExtraData meta = texture->extraData();
+			if (!meta.fields().isEmpty()) {
+				QString destPathMeta = _args.destinationMeta(path, num);
+				if (!meta.save(destPathMeta)) {
+					qWarning() << "Error: Cannot save extra data";
+					return false;
+				} else {
+					printPath(destPathMeta);
+					if (outputs) {
+						outputs->append(destPathMeta);
+					}
+				}
+			}
+		}
+
+		// Palettes are in raw files and index atlases
+		if (_args.exportPalettes() && !raw && !(atlas && _args.atlas() == "index")
+		        && texture->depth() < 16) { // Do not use isPaletted for that!
+			QImage palette = texture->palette();
+			if (!palette.isNull()) {
+				QString destPathPalette = _args.destinationPalette(path, num);
+				if (!saveImage(palette, destPathPalette)) {
+					qWarning() << "Error: Cannot save palette";
+					return false;
+				}
+				printPath(destPathPalette);
+				if (outputs) {
+					outputs->append(destPathPalette);
+				}
+			} else {
+				qWarning() << "Warning: No palette to export";
+				return false;
+			}
+		}
+	}
+
+	if (error) {
+		qWarning() << "Error: Cannot save image";
+	}
+
+	return !error;
+}
+
+bool Converter::toTexture(TextureFile *texture, const QString &path, int num,
+                          QStringList *outputs)
+{
+	QString pathMeta = _args.inputPathMeta(path),
+	        pathPalette = _args.inputPathPalette(path);
+
+	if (pathMeta.isEmpty()) {
+		qWarning() << "Error: Please set the input path meta";
+		return false;
+	}
+
+	TextureFile *tex;
+	QString destPath;
+
+	if (_args.outputFormat().compare("tex", Qt::CaseInsensitive) == 0) {
+		tex = new TexFile(*texture);
+	} else if (_args.outputFormat().compare("tim", Qt::CaseInsensitive) == 0) {
+		tex = new TimFile(*texture);
+	} else {
+		qWarning() << "toTexture: output format not supported";
+		return false;
+	}
+
+	ExtraData meta;
+	if (!meta.open(pathMeta)) {
+		qWarning() << "Meta data not found!" << QDir::toNativeSeparators(pathMeta);
+		goto toTextureError;
+	}
+	tex->setExtraData(meta);
+
+	// Not texture to texture
+	if (_args.outputFormat().compare(_args.inputFormat(path), Qt::CaseInsensitive) != 0
+	        && tex->depth() < 16) { // Do not use isPaletted for that!
+		QImage paletteImage;
+		if (pathPalette.isEmpty()) {
+			if (TextureFile::supportedTextureFormats().contains(_args.inputFormat(path), Qt::CaseInsensitive)) {
+				qWarning() << "Error: Please set the input path palette";
+				goto toTextureError;
+			}
+
+			// No palette for new images
+			if (!tex->quantize(tex->depth())) {
+				qWarning() << "Error: Please set the depth in the meta file";
+				goto toTextureError;
+			}
+		} else if (paletteImage.load(pathPalette)) {
+			if (!tex->setPalette(paletteImage)) {
+				qWarning() << "Error: Please set the depth in the meta file";
+				goto toTextureError;
+			}
+
+			if (_args.palette() < 0 || _args.palette() >= tex->colorTableCount()) {
+				qWarning() << "Error: Please set a valid number of palette";
+				goto toTextureError;
+			}
+
+			int offPalette = tex->convertToIndexedFormat(_args.palette());
+			if (offPalette > 0) {
+				qWarning() << "Warning:" << offPalette << "pixels are not in the palette, nearest colors used";
+			}
+		} else {
+			qWarning() << "Error: Cannot open the input palette";
+			goto toTextureError;
+		}
+	} else if (tex->depth() >= 16 && tex->isPaletted()) {
+		// Paletted image to 16-bit texture
+		tex->convertToTrueColor();
+	}
+
+	if (_args.shrinkPalettes()) {
+		tex->shrinkPalettes();
+	}
+
+	destPath = _args.destination(path, num);
+
+	if (_args.packVram() && _args.outputFormat().compare("tim", Qt::CaseInsensitive) == 0) {
+		// Saved and printed by packVram(), once the positions are known
+		VramTexture texture;
+		texture.tim = static_cast<TimFile *>(tex);
+		texture.path = path;
+		texture.destPath = destPath;
+		_vramTextures.append(texture);
+		return true;
+	}
+
+	if (!tex->saveToFile(destPath)) {
+		goto toTextureError;
+	}
+
+	printPath(destPath);
+	if (outputs) {
+		outputs->append(destPath);
+	}
+
+	delete tex;
+	return true;
+toTextureError:
+	delete tex;
+	return false;
+}
+
+QStringList Converter::dependencies(const QString &path) const
+{
+	QStringList ret(path);
+
+	if (TextureFile::supportedTextureFormats().contains(_args.outputFormat(), Qt::CaseInsensitive)) {
+		QString pathMeta = _args.inputPathMeta(path),
+		        pathPalette = _args.inputPathPalette(path);
+		if (!pathMeta.isEmpty()) {
+			ret.append(pathMeta);
+		}
+		if (!pathPalette.isEmpty()) {
+			ret.append(pathPalette);
+		}
+	}
+
+	return ret;
+}
+
+bool Converter::convert(const QString &path)
+{
+	TextureFile *texture;
+	QStringList deps, outputs;
+	bool ok = false;
+
+	TraceSpan span("file", path);
+
+	if (_buildDb) {
+		deps = dependencies(path);
+		if (_buildDb->isUpToDate(path, deps, _options)) {
+			foreach (const QString &output, _buildDb->outputs(path)) {
+				printPath(output);
+			}
+			return true;
+		}
+	}
+
+	if (_args.inputFormat(path) == _args.outputFormat()) {
+		qWarning() << "Error: input and output formats are not different";
+		_exitCode = 1;
+	}
+
+	QFile f(path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(path) << f.errorString();
+		return false;
+	}
+
+	if (!_args.analysis() && transcode(f, path, &outputs, &ok)) {
+		f.close();
+	} else if (!_args.analysis()) {
+		texture = openTexture(f, _args.inputFormat(path));
+
+		if (texture) {
+			if (TextureFile::supportedTextureFormats().contains(_args.outputFormat(), Qt::CaseInsensitive)) {
+				// On failure, the next inputs are still converted
+				ok = toTexture(texture, path, -1, &outputs);
+			} else if (TextureFile::supportedTextureFormats().contains(_args.inputFormat(path), Qt::CaseInsensitive)) {
+				ok = fromTexture(texture, path, -1, &outputs);
+			} else {
+				qWarning() << "Error: input format or output format must be a supported texture format" << TextureFile::supportedTextureFormats();
+			}
+		} else {
+			qWarning() << "Error: Cannot open Texture file";
+		}
+
+		f.close();
+
+		delete texture;
+	} else { // Search tim files
+		ok = analysis(f, path, outputs);
+	}
+
+	if (_buildDb && ok) {
+		_buildDb->update(path, deps, _options, outputs);
+	}
+
+	Stats::addFile();
+
+	return ok;
+}
+
+/*
+ * TIM to TEX (or TEX to TIM) without decoding the texture.
+ * Returns false when the conversion must be done with TimFile and TexFile.
+ */
+bool Converter::transcode(QFile &f, const QString &path, QStringList *outputs, bool *ok)
+{
+	const QString inputFormat = _args.inputFormat(path).toLower(),
+	        outputFormat = _args.outputFormat().toLower();
+
+	// The embedded palettes are copied, a palette file is applied by toTexture()
+	if (_args.shrinkPalettes() || _args.packVram()
+	        || _args.palette() >= 0 || !_args.inputPathPalette(path).isEmpty()
+	        || !((inputFormat == "tim" && outputFormat == "tex")
+	             || (inputFormat == "tex" && outputFormat == "tim"))) {
+		return false;
+	}
+
+	// Errors are reported by the other conversion
+	const QString pathMeta = _args.inputPathMeta(path);
+	ExtraData meta;
+	if (pathMeta.isEmpty() || !meta.open(pathMeta)) {
+		return false;
+	}
+
+	QByteArray data, converted;
+	{
+		StatsTimer timer(Stats::Read, f.size());
+		data = f.readAll();
+	}
+
+	{
+		StatsTimer timer(Stats::Transcode, data.size());
+		if (!(inputFormat == "tim"
+		      ? Transcoder::timToTex(data, meta, converted)
+		      : Transcoder::texToTim(data, meta, converted))) {
+			f.reset();
+			return false;
+		}
+	}
+
+	const QString destPath = _args.destination(path);
+	StatsTimer timer(Stats::Write, converted.size());
+	QFile out(destPath);
+	if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)
+	        || out.write(converted) != converted.size()) {
+		qWarning() << "Error: Cannot save Texture file" << QDir::toNativeSeparators(destPath) << out.errorString();
+		*ok = false;
+		return true;
+	}
+
+	printPath(destPath);
+	outputs->append(destPath);
+	*ok = true;
+
+	return true;
+}
+
+/*
+ * Returns the opened texture, or NULL on error.
+ */
+TextureFile *Converter::openTexture(QFile &f, const QString &format)
+{
+	TextureFile *texture;
+
+	if (_cache) {
+		texture = _cache->object(f.fileName(), format);
+		if (texture) {
+			return texture;
+		}
+	}
+
+	texture = TextureFile::factory(format);
+
+	QByteArray data;
+	{
+		StatsTimer timer(Stats::Read, f.size());
+		data = f.readAll();
+	}
+
+	if (!texture->open(data)) {
+		delete texture;
+		return NULL;
+	}
+
+	if (_cache) {
+		_cache->insert(f.fileName(), format, texture);
+	}
+
+	return texture;
+}
+
+bool Converter::analysis(QFile &f, const QString &path, QStringList &outputs)
+{
+	QList<PosSize> positions;
+	{
+		TraceSpan span("findTims", path);
+		positions = TimFile::findTims(&f);
+	}
+	Deduplicator duplicates;
+	Vram vram;
+	bool ok = true;
+
+	int num = 0;
+	foreach (const PosSize &pos, positions) {
+		TraceSpan span("hit", Trace::isEnabled() ? QString("0x%1").arg(pos.first, 8, 16, QChar('0')) : QString());
+		QByteArray data;
+		{
+			StatsTimer timer(Stats::Read, pos.second);
+			f.seek(pos.first);
+			data = f.read(pos.second);
+		}
+		quint64 hash = 0;
+
+		if (_args.dedupe()) {
+			hash = Hash::xxh64(data);
+			int originalNum = duplicates.find(&f, data, hash);
+			if (originalNum >= 0) {
+				duplicates.addDuplicate(num, originalNum, pos.first, pos.second, hash);
+				print(QString("%1\n0x%2 -> 0x%3 (%4 B) duplicate of %5")
+				      .arg(QDir::toNativeSeparators(f.fileName()))
+				      .arg(pos.first, 8, 16, QChar('0'))
+				      .arg(pos.first + pos.second - 1, 8, 16, QChar('0'))
+				      .arg(pos.second)
+				      .arg(originalNum));
+				if (_args.hardLink()) {
+					// Outputs of the original all start with the same prefix
+					const QString originalPrefix = _args.destinationPrefix(path, originalNum),
+					        prefix = _args.destinationPrefix(path, num);
+					foreach (const QString &original, duplicates.outputs(originalNum)) {
+						QString destPath = prefix + original.mid(originalPrefix.size());
+						if (!Deduplicator::hardLink(original, destPath)) {
+							qWarning() << "Error: Cannot link" << QDir::toNativeSeparators(destPath);
+							ok = false;
+						} else {
+							printPath(destPath);
+							outputs.append(destPath);
+						}
+					}
+				}
+				num++;
+				continue;
+			}
+		}
+
+		TimFile texture;
+		if (texture.open(data)) {
+			QStringList textureOutputs;
+			print(QString("%1\n0x%2 -> 0x%3 (%4 B)")
+			      .arg(QDir::toNativeSeparators(f.fileName()))
+			      .arg(pos.first, 8, 16, QChar('0'))
+			      .arg(pos.first + pos.second - 1, 8, 16, QChar('0'))
+			      .arg(pos.second));
+			if (_args.vram()) {
+				bool overlap = false;
+				vram.uploadTim(data, &overlap);
+				if (overlap) {
+					qWarning() << "Warning: TIM" << num << "overwrites VRAM used by a previous TIM";
+				}
+			}
+			if (_args.outputFormat().compare("tim", Qt::CaseInsensitive) == 0) {
+				if (_args.shrinkPalettes()) {
+					texture.shrinkPalettes();
+				}
+				if (!texture.saveToFile(_args.destination(path, num))) {
+					qWarning() << "Error: Cannot save Texture file from" << QDir::toNativeSeparators(path) << "to" << _args.destination(path, num);
+					ok = false;
+					continue;
+				} else {
+					printPath(_args.destination(path, num));
+					textureOutputs.append(_args.destination(path, num));
+				}
+			} else if (!fromTexture(&texture, path, num, &textureOutputs)) {
+				ok = false;
+			}
+			if (_args.dedupe()) {
+				duplicates.insert(pos.first, pos.second, hash, num, textureOutputs);
+			}
+			outputs.append(textureOutputs);
+			num++;
+		} else {
+			qWarning() << "Error: Cannot open Texture file from" << QDir::toNativeSeparators(path);
+			ok = false;
+		}
+	}
+
+	if (duplicates.duplicateCount() > 0) {
+		QString destPathManifest = _args.destinationDuplicates(path);
+		if (!duplicates.saveManifest(destPathManifest)) {
+			qWarning() << "Error: Cannot save duplicates manifest";
+			ok = false;
+		} else {
+			printPath(destPathManifest);
+			outputs.append(destPathManifest);
+		}
+	}
+
+	if (_args.vram()) {
+		QString destPathVram = _args.destinationVram(path);
+		if (!saveImage(vram.view(), destPathVram)) {
+			qWarning() << "Error: Cannot save VRAM image" << QDir::toNativeSeparators(destPathVram);
+			ok = false;
+		} else {
+			printPath(destPathVram);
+			outputs.append(destPathVram);
+		}
+
+		foreach (const VramPage &page, _args.vramPages()) {
+			QImage image = vram.texturePage(page.page, page.depth, page.clutX, page.clutY);
+			QString destPathPage = _args.destinationVramPage(path, page);
+			if (image.isNull() || !saveImage(image, destPathPage)) {
+				qWarning() << "Error: Cannot save VRAM page" << QDir::toNativeSeparators(destPathPage);
+				ok = false;
+			} else {
+				printPath(destPathPage);
+				outputs.append(destPathPage);
+			}
+		}
+	}
+
+	return ok;
+}
@@ -0,0 +1,78 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef CONVERTER_H
+#define CONVERTER_H
+
+#include <QtCore>
+#include "Arguments.h"
+
+class QImage;
+class TextureFile;
+class TimFile;
+class TextureCache;
+class BuildDatabase;
+
+/*
+ * Converts the input files given by Arguments.
+ * Produced files are reported with print(), errors with qWarning().
+ */
+class Converter
+{
+public:
+	explicit Converter(const Arguments &args, TextureCache *cache = 0);
+	virtual ~Converter();
+	int exec();
+	bool convert(const QString &path);
+protected:
+	virtual void print(const QString &text);
+private:
+	bool saveImage(const QImage &image, const QString &destPath);
+	bool saveTextureTo(TextureFile *texture, const QString &destPath);
+	bool saveAtlasTo(TextureFile *texture, const QString &path, int num,
+	                 QStringList *outputs);
+	bool saveRawTo(TextureFile *texture, const QString &path, int num,
+	               QStringList *outputs);
+	bool fromTexture(TextureFile *texture, const QString &path, int num = -1,
+	                 QStringList *outputs = 0);
+	bool toTexture(TextureFile *texture, const QString &path, int num = -1,
+	               QStringList *outputs = 0);
+	bool transcode(QFile &f, const QString &path, QStringList *outputs, bool *ok);
+	TextureFile *openTexture(QFile &f, const QString &format);
+	bool analysis(QFile &f, const QString &path, QStringList &outputs);
+	QStringList dependencies(const QString &path) const;
+	void printPath(const QString &path);
+	bool packVram();
+	static QMutex *buildDbMutex(const QString &path);
+
+	const Arguments &_args;
+	TextureCache *_cache;
+	BuildDatabase *_buildDb;
+	QFile *_rawConcat;
+	// With --pack-vram, TIM files are saved once every position is known
+	struct VramTexture {
+		TimFile *tim;
+		QString path, destPath;
+	};
+	QList<VramTexture> _vramTextures;
+	QString _options;
+	int _exitCode;
+	// One mutex per build database, jobs using different files run concurrently
+	static QMutex _buildDbMutexesGuard;
+	static QHash<QString, QMutex *> _buildDbMutexes;
+};
+
+#endif // CONVERTER_H
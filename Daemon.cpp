@@ -0,0 +1,283 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Daemon.h"
+#include "Converter.h"
+#include "TextureCache.h"
+
+#define DAEMON_QUIT_WRITE_TIMEOUT	5000 // ms, per write
+
+class DaemonJob;
+
+// Job running in the current thread, to forward its warnings
+static thread_local DaemonJob *currentJob = 0;
+static QtMessageHandler previousMessageHandler = 0;
+
+class DaemonJob : public QRunnable
+{
+public:
+	DaemonJob(Daemon *daemon, quint64 connectionId, const QJsonValue &id,
+	          Arguments *args, TextureCache *cache) :
+		_daemon(daemon), _connectionId(connectionId), _id(id), _args(args),
+		_cache(cache)
+	{
+	}
+	virtual ~DaemonJob() {
+		delete _args;
+	}
+	void run();
+	void send(QJsonObject object);
+private:
+	Daemon *_daemon;
+	quint64 _connectionId;
+	QJsonValue _id;
+	Arguments *_args;
+	TextureCache *_cache;
+};
+
+class DaemonConverter : public Converter
+{
+public:
+	DaemonConverter(const Arguments &args, TextureCache *cache, DaemonJob *job) :
+		Converter(args, cache), _job(job)
+	{
+	}
+protected:
+	void print(const QString &text) {
+		QJsonObject object;
+		object.insert("output", text);
+		_job->send(object);
+	}
+private:
+	DaemonJob *_job;
+};
+
+void DaemonJob::run()
+{
+	QElapsedTimer t;
+	t.start();
+
+	currentJob = this;
+	DaemonConverter converter(*_args, _cache, this);
+	int exitCode = converter.exec();
+	currentJob = 0;
+
+	QJsonObject object;
+	object.insert("status", exitCode == 0 ? "done" : "failed");
+	object.insert("exitCode", exitCode);
+	object.insert("elapsed", double(t.nsecsElapsed()) / 1000000.0);
+	send(object);
+}
+
+void DaemonJob::send(QJsonObject object)
+{
+	object.insert("id", _id);
+	QMetaObject::invokeMethod(_daemon, "reply", Qt::QueuedConnection,
+	                          Q_ARG(quint64, _connectionId),
+	                          Q_ARG(QByteArray, QJsonDocument(object).toJson(QJsonDocument::Compact)));
+}
+
+static void daemonMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+	if (currentJob && type != QtDebugMsg) {
+		QJsonObject object;
+		object.insert("warning", msg);
+		currentJob->send(object);
+		return;
+	}
+
+	if (previousMessageHandler) {
+		previousMessageHandler(type, context, msg);
+	} else {
+		fprintf(stderr, "%s\n", qPrintable(msg));
+	}
+}
+
+Daemon::Daemon(const Arguments &args, QObject *parent) :
+	QObject(parent), _args(args), _cache(0), _lastConnectionId(0)
+{
+	if (_args.threads() > 0) {
+		_pool.setMaxThreadCount(_args.threads());
+	}
+
+	if (_args.cacheSize() > 0) {
+		_cache = new TextureCache(_args.cacheSize());
+	}
+
+	connect(&_server, SIGNAL(newConnection()), SLOT(addConnection()));
+}
+
+Daemon::~Daemon()
+{
+	_server.close();
+	_pool.waitForDone();
+	qInstallMessageHandler(previousMessageHandler);
+	delete _cache;
+}
+
+bool Daemon::listen()
+{
+	// Remove a socket left by a previous instance
+	QLocalServer::removeServer(_args.daemon());
+
+	if (!_server.listen(_args.daemon())) {
+		qWarning() << "Error: Cannot listen to" << _args.daemon() << _server.errorString();
+		return false;
+	}
+
+	previousMessageHandler = qInstallMessageHandler(daemonMessageHandler);
+
+	printf("Listening to %s with %d threads\n",
+	       qPrintable(QDir::toNativeSeparators(_server.fullServerName())),
+	       _pool.maxThreadCount());
+	fflush(stdout);
+
+	return true;
+}
+
+void Daemon::addConnection()
+{
+	while (_server.hasPendingConnections()) {
+		QLocalSocket *socket = _server.nextPendingConnection();
+		quint64 connectionId = ++_lastConnectionId;
+
+		socket->setProperty("connectionId", connectionId);
+		_connections.insert(connectionId, socket);
+
+		connect(socket, SIGNAL(readyRead()), SLOT(readJobs()));
+		connect(socket, SIGNAL(disconnected()), SLOT(removeConnection()));
+	}
+}
+
+void Daemon::removeConnection()
+{
+	QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+	if (socket) {
+		// Replies to the running jobs of this connection will be dropped
+		_connections.remove(socket->property("connectionId").toULongLong());
+		socket->deleteLater();
+	}
+}
+
+void Daemon::readJobs()
+{
+	QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+	if (!socket) {
+		return;
+	}
+
+	quint64 connectionId = socket->property("connectionId").toULongLong();
+
+	while (socket->canReadLine()) {
+		QByteArray line = socket->readLine().trimmed();
+		if (!line.isEmpty()) {
+			processJob(connectionId, line);
+		}
+	}
+}
+
+void Daemon::processJob(quint64 connectionId, const QByteArray &line)
+{
+	QJsonParseError error;
+	QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+
+	if (!doc.isObject()) {
+		replyError(connectionId, QJsonValue(), error.error != QJsonParseError::NoError
+		           ? error.errorString() : QString("A job must be a JSON object"));
+		return;
+	}
+
+	QJsonObject job = doc.object();
+	QJsonValue id = job.value("id");
+
+	if (job.value("command").toString() == "quit") {
+		_server.close();
+		_pool.waitForDone();
+		// Deliver the last replies before leaving the event loop
+		QCoreApplication::sendPostedEvents(this);
+
+		QJsonObject object;
+		object.insert("id", id);
+		object.insert("status", "quit");
+		reply(connectionId, QJsonDocument(object).toJson(QJsonDocument::Compact));
+
+		// flush() does not wait, the event loop will not run again
+		foreach (QLocalSocket *socket, _connections) {
+			while (socket->bytesToWrite() > 0
+			       && socket->waitForBytesWritten(DAEMON_QUIT_WRITE_TIMEOUT)) {
+			}
+		}
+		QCoreApplication::quit();
+		return;
+	} else if (job.value("command").toString() == "stats") {
+		replyStats(connectionId, id);
+		return;
+	}
+
+	QStringList arguments(QCoreApplication::applicationFilePath());
+	foreach (const QJsonValue &argument, job.value("arguments").toArray()) {
+		arguments.append(argument.toString());
+	}
+
+	Arguments *args = new Arguments(arguments);
+
+	if (!args->isValid()) {
+		replyError(connectionId, id, args->errorText());
+		delete args;
+		return;
+	}
+
+	if (args->help() || args->paths().isEmpty()) {
+		replyError(connectionId, id, "No input files");
+		delete args;
+		return;
+	}
+
+	_pool.start(new DaemonJob(this, connectionId, id, args, _cache));
+}
+
+void Daemon::replyError(quint64 connectionId, const QJsonValue &id, const QString &error)
+{
+	QJsonObject object;
+	object.insert("id", id);
+	object.insert("status", "error");
+	object.insert("error", error);
+	reply(connectionId, QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+void Daemon::replyStats(quint64 connectionId, const QJsonValue &id)
+{
+	QJsonObject object, cache;
+	object.insert("id", id);
+	object.insert("activeJobs", _pool.activeThreadCount());
+	if (_cache) {
+		cache.insert("hits", double(_cache->hits()));
+		cache.insert("misses", double(_cache->misses()));
+		cache.insert("bytes", double(_cache->bytes()));
+		cache.insert("maxBytes", double(_cache->maxBytes()));
+		object.insert("cache", cache);
+	}
+	reply(connectionId, QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+void Daemon::reply(quint64 connectionId, const QByteArray &line)
+{
+	QLocalSocket *socket = _connections.value(connectionId);
+	if (socket) {
+		socket->write(line);
+		socket->write("\n");
+	}
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <QtCore>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "Arguments.h"
+
+class TextureCache;
+
+/*
+ * Listens to a local socket for conversion jobs, one JSON object per line:
+ * {"id": 1, "arguments": ["--of", "png", "foo.tim", "output_directory"]}
+ * Jobs are run on a thread pool, produced files, warnings and the final status
+ * are sent back as JSON lines with the same id.
+ * Opened textures are kept in a cache shared by all jobs.
+ */
+class Daemon : public QObject
+{
+	Q_OBJECT
+public:
+	explicit Daemon(const Arguments &args, QObject *parent = 0);
+	virtual ~Daemon();
+	bool listen();
+	Q_INVOKABLE void reply(quint64 connectionId, const QByteArray &line);
+private slots:
+	void addConnection();
+	void readJobs();
+	void removeConnection();
+private:
+	void processJob(quint64 connectionId, const QByteArray &line);
+	void replyError(quint64 connectionId, const QJsonValue &id, const QString &error);
+	void replyStats(quint64 connectionId, const QJsonValue &id);
+
+	const Arguments &_args;
+	QLocalServer _server;
+	QThreadPool _pool;
+	TextureCache *_cache;
+	QHash<quint64, QLocalSocket *> _connections;
+	quint64 _lastConnectionId;
+};
+
+#endif // DAEMON_H
@@ -0,0 +1,130 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Deduplicator.h"
+#include "Hash.h"
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+Deduplicator::Deduplicator()
+{
+}
+
+/*
+ * Returns the number of the first identical copy of data,
+ * or -1 if data was never inserted.
+ * Inserted copies are not kept in memory, they are read
+ * back from device, which keeps its position.
+ */
+int Deduplicator::find(QIODevice *device, const QByteArray &data, quint64 hash) const
+{
+	QMultiHash<quint64, Entry>::const_iterator it = _entries.constFind(hash);
+	if (it == _entries.constEnd()) {
+		return -1;
+	}
+
+	const qint64 pos = device->pos();
+	int num = -1;
+	while (it != _entries.constEnd() && it.key() == hash) {
+		const Entry &entry = it.value();
+		// Compare bytes too, hash collisions are not impossible
+		if (entry.size == data.size() && device->seek(entry.offset)
+		        && device->read(entry.size) == data) {
+			num = entry.num;
+			break;
+		}
+		++it;
+	}
+	device->seek(pos);
+
+	return num;
+}
+
+void Deduplicator::insert(qint64 offset, int size, quint64 hash, int num, const QStringList &outputs)
+{
+	Entry entry;
+	entry.num = num;
+	entry.offset = offset;
+	entry.size = size;
+	_entries.insert(hash, entry);
+	_outputs.insert(num, outputs);
+}
+
+void Deduplicator::addDuplicate(int num, int originalNum, qint64 offset, int size, quint64 hash)
+{
+	Duplicate dup;
+	dup.num = num;
+	dup.originalNum = originalNum;
+	dup.offset = offset;
+	dup.size = size;
+	dup.hash = hash;
+	_duplicates.append(dup);
+}
+
+QStringList Deduplicator::outputs(int num) const
+{
+	return _outputs.value(num);
+}
+
+bool Deduplicator::saveManifest(const QString &filename) const
+{
+	QFile f(filename);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+		return false;
+	}
+
+	f.write("# num original offset size hash\n");
+
+	foreach (const Duplicate &dup, _duplicates) {
+		f.write(QString("%1 %2 0x%3 %4 %5\n")
+		        .arg(dup.num)
+		        .arg(dup.originalNum)
+		        .arg(dup.offset, 8, 16, QChar('0'))
+		        .arg(dup.size)
+		        .arg(Hash::toHex(dup.hash))
+		        .toLatin1());
+	}
+
+	f.close();
+
+	return true;
+}
+
+bool Deduplicator::hardLink(const QString &target, const QString &linkName)
+{
+	if (QFile::exists(linkName) && !QFile::remove(linkName)) {
+		return false;
+	}
+
+#if defined(Q_OS_UNIX)
+	if (::link(QFile::encodeName(target).constData(),
+	           QFile::encodeName(linkName).constData()) == 0) {
+		return true;
+	}
+#elif defined(Q_OS_WIN)
+	if (CreateHardLinkW((LPCWSTR)QDir::toNativeSeparators(linkName).utf16(),
+	                    (LPCWSTR)QDir::toNativeSeparators(target).utf16(), NULL)) {
+		return true;
+	}
+#endif
+
+	// Different file systems, or not supported
+	return QFile::copy(target, linkName);
+}
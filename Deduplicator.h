@@ -0,0 +1,52 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef DEDUPLICATOR_H
+#define DEDUPLICATOR_H
+
+#include <QtCore>
+
+class Deduplicator
+{
+public:
+	Deduplicator();
+	int find(QIODevice *device, const QByteArray &data, quint64 hash) const;
+	void insert(qint64 offset, int size, quint64 hash, int num, const QStringList &outputs);
+	void addDuplicate(int num, int originalNum, qint64 offset, int size, quint64 hash);
+	QStringList outputs(int num) const;
+	inline int duplicateCount() const {
+		return _duplicates.size();
+	}
+	bool saveManifest(const QString &filename) const;
+	static bool hardLink(const QString &target, const QString &linkName);
+private:
+	struct Entry {
+		int num;
+		qint64 offset;
+		int size;
+	};
+	struct Duplicate {
+		int num, originalNum;
+		qint64 offset;
+		int size;
+		quint64 hash;
+	};
+	QMultiHash<quint64, Entry> _entries;
+	QList<Duplicate> _duplicates;
+	QMap<int, QStringList> _outputs;
+};
+
+#endif // DEDUPLICATOR_H
@@ -16,12 +16,8 @@
  ****************************************************************************/
 #include "ExtraData.h"
 #include <QFile>
-#include <QRegExp>
-#include <QStringList>
 #include <QDebug>
 
-#define EXTRA_DATA_MAX_LINE_WIDTH	128
-
 ExtraData::ExtraData(const QMap<QString, QVariant> &fields) :
     _fields(fields)
 {
@@ -35,31 +31,125 @@ bool ExtraData::open(const QString &filename)
 
 bool ExtraData::open(QIODevice *device)
 {
-	if (!device->open(QIODevice::ReadOnly | QIODevice::Text)) {
+	if (!device->open(QIODevice::ReadOnly)) {
 		return false;
 	}
-	QRegExp re("(\\w+)\\s*=\\s*(.+)");
 
-	forever {
-		QString line = QString(device->readLine(EXTRA_DATA_MAX_LINE_WIDTH)).trimmed();
-		if (line.isEmpty()) {
-			break;
+	QFile *file = qobject_cast<QFile *>(device);
+	const qint64 size = device->size();
+	uchar *mapped = 0;
+	QByteArray data;
+
+	// Meta files are small and read once, avoid copying them
+	if (file != 0 && size > 0) {
+		mapped = file->map(0, size);
+	}
+	if (mapped == 0) {
+		data = device->readAll();
+	}
+
+	const bool ok = mapped != 0
+	        ? parse((const char *)mapped, size, file->fileName())
+	        : parse(data.constData(), data.size(), file != 0 ? file->fileName() : QString());
+
+	if (mapped != 0) {
+		file->unmap(mapped);
+	}
+	device->close();
+
+	return ok;
+}
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool isKeyChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+	        || (c >= '0' && c <= '9') || c == '_';
+}
+
+/*
+ * One "key = value" per line. Blank lines and lines starting with '#' are
+ * skipped, " #" starts a comment after a value (a value can start with
+ * '#'). Values made of decimal digits that fit in 32 bits are stored as
+ * integers, the others as strings.
+ */
+bool ExtraData::parse(const char *data, qint64 size, const QString &name)
+{
+	const char *cur = data, *end = data + size;
+	int lineNumber = 0;
+
+	while (cur < end) {
+		const char *lineEnd = (const char *)memchr(cur, '\n', end - cur);
+		if (lineEnd == 0) {
+			lineEnd = end;
 		}
-		if (line.startsWith('#')) {
+		++lineNumber;
+
+		const char *c = cur, *last = lineEnd;
+		cur = lineEnd + 1;
+
+		while (c < last && isBlank(*c)) {
+			++c;
+		}
+		while (last > c && isBlank(last[-1])) {
+			--last;
+		}
+		if (c == last || *c == '#') {
 			continue;
 		}
 
-		if (re.exactMatch(line)) {
-			QStringList capturedTexts = re.capturedTexts();
-			QString key = capturedTexts.at(1);
-			QString value = capturedTexts.at(2);
-			_fields.insert(key, QVariant(value));
-		} else {
+		const char *key = c;
+		while (c < last && isKeyChar(*c)) {
+			++c;
+		}
+		const int keySize = int(c - key);
+
+		while (c < last && isBlank(*c)) {
+			++c;
+		}
+		if (keySize == 0 || c == last || *c != '=') {
+			qWarning() << "Error: Invalid meta data" << name << "line" << lineNumber
+			           << "expected key = value";
+			return false;
+		}
+		++c;
+		while (c < last && isBlank(*c)) {
+			++c;
+		}
+		// Trailing comment, '#' must follow a blank inside the value
+		for (const char *comment = c + 1; comment < last; ++comment) {
+			if (*comment == '#' && isBlank(comment[-1])) {
+				last = comment;
+				break;
+			}
+		}
+		while (last > c && isBlank(last[-1])) {
+			--last;
+		}
+		if (c == last) {
+			qWarning() << "Error: Invalid meta data" << name << "line" << lineNumber
+			           << "missing value for" << QByteArray(key, keySize);
 			return false;
 		}
-	}
 
-	device->close();
+		const char *value = c;
+		const int valueSize = int(last - value);
+		quint64 number = 0;
+
+		while (c < last && *c >= '0' && *c <= '9' && number <= 0xFFFFFFFF) {
+			number = number * 10 + quint64(*c - '0');
+			++c;
+		}
+
+		_fields.insert(QString::fromLatin1(key, keySize),
+		               c == last && number <= 0xFFFFFFFF
+		               ? QVariant(quint32(number))
+		               : QVariant(QString::fromUtf8(value, valueSize)));
+	}
 
 	return true;
 }
@@ -33,6 +33,8 @@ public:
 		return _fields;
 	}
 private:
+	bool parse(const char *data, qint64 size, const QString &name);
+
 	QMap<QString, QVariant> _fields;
 };
 
@@ -0,0 +1,119 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Hash.h"
+
+#define XXH_PRIME64_1	Q_UINT64_C(0x9E3779B185EBCA87)
+#define XXH_PRIME64_2	Q_UINT64_C(0xC2B2AE3D27D4EB4F)
+#define XXH_PRIME64_3	Q_UINT64_C(0x165667B19E3779F9)
+#define XXH_PRIME64_4	Q_UINT64_C(0x85EBCA77C2B2AE63)
+#define XXH_PRIME64_5	Q_UINT64_C(0x27D4EB2F165667C5)
+
+static inline quint64 rotl64(quint64 x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64 read64(const char *p)
+{
+	quint64 v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline quint32 read32(const char *p)
+{
+	quint32 v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline quint64 xxhRound(quint64 acc, quint64 input)
+{
+	acc += input * XXH_PRIME64_2;
+	acc = rotl64(acc, 31);
+	return acc * XXH_PRIME64_1;
+}
+
+static inline quint64 xxhMergeRound(quint64 acc, quint64 val)
+{
+	acc ^= xxhRound(0, val);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+quint64 Hash::xxh64(const char *data, qint64 size, quint64 seed)
+{
+	const char *p = data, *end = data + size;
+	quint64 h;
+
+	if (size >= 32) {
+		const char *limit = end - 32;
+		quint64 v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2,
+		        v2 = seed + XXH_PRIME64_2,
+		        v3 = seed,
+		        v4 = seed - XXH_PRIME64_1;
+
+		do {
+			v1 = xxhRound(v1, read64(p));
+			v2 = xxhRound(v2, read64(p + 8));
+			v3 = xxhRound(v3, read64(p + 16));
+			v4 = xxhRound(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		h = xxhMergeRound(h, v1);
+		h = xxhMergeRound(h, v2);
+		h = xxhMergeRound(h, v3);
+		h = xxhMergeRound(h, v4);
+	} else {
+		h = seed + XXH_PRIME64_5;
+	}
+
+	h += quint64(size);
+
+	while (p + 8 <= end) {
+		h ^= xxhRound(0, read64(p));
+		h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		p += 8;
+	}
+
+	if (p + 4 <= end) {
+		h ^= quint64(read32(p)) * XXH_PRIME64_1;
+		h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+
+	while (p < end) {
+		h ^= quint64(quint8(*p)) * XXH_PRIME64_5;
+		h = rotl64(h, 11) * XXH_PRIME64_1;
+		++p;
+	}
+
+	// Avalanche
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+QString Hash::toHex(quint64 hash)
+{
+	return QString("%1").arg(hash, 16, 16, QChar('0'));
+}
@@ -0,0 +1,33 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef HASH_H
+#define HASH_H
+
+#include <QtCore>
+
+class Hash
+{
+public:
+	// Fast non-cryptographic 64-bit hash (xxHash64 algorithm)
+	static quint64 xxh64(const char *data, qint64 size, quint64 seed = 0);
+	inline static quint64 xxh64(const QByteArray &data, quint64 seed = 0) {
+		return xxh64(data.constData(), data.size(), seed);
+	}
+	static QString toHex(quint64 hash);
+};
+
+#endif // HASH_H
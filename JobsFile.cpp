@@ -0,0 +1,187 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "JobsFile.h"
+#include "Converter.h"
+#include "TextureCache.h"
+#include "Trace.h"
+
+class JobsFileJob : public QRunnable
+{
+public:
+	JobsFileJob(const QString &jobsFile, int lineNumber, const QString &line,
+	            TextureCache *cache, QAtomicInt *failures, QSemaphore *queued) :
+		_jobsFile(jobsFile), _lineNumber(lineNumber), _line(line),
+		_cache(cache), _failures(failures), _queued(queued)
+	{
+	}
+	virtual ~JobsFileJob() {
+		_queued->release();
+	}
+	void run();
+private:
+	void fail(const QString &error);
+
+	QString _jobsFile;
+	int _lineNumber;
+	QString _line;
+	TextureCache *_cache;
+	QAtomicInt *_failures;
+	QSemaphore *_queued;
+};
+
+void JobsFileJob::fail(const QString &error)
+{
+	qWarning() << qPrintable(QString("%1:%2:").arg(QDir::toNativeSeparators(_jobsFile)).arg(_lineNumber))
+	           << qPrintable(error);
+	_failures->ref();
+}
+
+void JobsFileJob::run()
+{
+	TraceSpan span("job", Trace::isEnabled() ? QString::number(_lineNumber) : QString());
+	bool ok;
+	// Parsed by the worker, the reading thread only queues the lines
+	QStringList arguments = JobsFile::splitCommandLine(_line, &ok);
+
+	if (!ok) {
+		fail("unterminated quote");
+		return;
+	}
+
+	arguments.prepend(QCoreApplication::applicationFilePath());
+
+	Arguments args(arguments);
+
+	if (!args.isValid()) {
+		fail(args.errorText());
+		return;
+	}
+
+	if (args.paths().isEmpty()) {
+		fail("no input files");
+		return;
+	}
+
+	Converter converter(args, _cache);
+	if (converter.exec() != 0) {
+		fail("job failed");
+	}
+}
+
+JobsFile::JobsFile(const Arguments &args) :
+	_args(args)
+{
+}
+
+int JobsFile::exec()
+{
+	QFile f(_args.jobsFile());
+	if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(f.fileName()) << f.errorString();
+		return 1;
+	}
+
+	QThreadPool pool;
+	TextureCache *cache = 0;
+	QAtomicInt failures(0);
+	int lineNumber = 0, jobCount = 0;
+
+	if (_args.threads() > 0) {
+		pool.setMaxThreadCount(_args.threads());
+	}
+
+	if (_args.cacheSize() > 0) {
+		cache = new TextureCache(_args.cacheSize());
+	}
+
+	// Lines are read as jobs finish, very long lists are not loaded at once
+	QSemaphore queued(2 * pool.maxThreadCount());
+
+	while (!f.atEnd()) {
+		QString line = QString::fromUtf8(f.readLine()).trimmed();
+		++lineNumber;
+
+		if (line.isEmpty() || line.startsWith('#')) {
+			continue;
+		}
+
+		queued.acquire();
+		pool.start(new JobsFileJob(f.fileName(), lineNumber, line, cache, &failures, &queued));
+		++jobCount;
+	}
+
+	pool.waitForDone();
+
+	if (failures.load() > 0) {
+		qWarning() << failures.load() << "of" << jobCount << "jobs failed";
+	}
+
+	delete cache;
+
+	return failures.load() > 0 ? 1 : 0;
+}
+
+/*
+ * Splits a line into arguments, like a shell:
+ * arguments are separated by spaces, unless quoted with " or '.
+ * In double quotes, \" and \\ are escaped quote and backslash
+ * (other backslashes are kept for Windows paths).
+ */
+QStringList JobsFile::splitCommandLine(const QString &line, bool *ok)
+{
+	QStringList ret;
+	QString argument;
+	QChar quote;
+	bool inArgument = false;
+
+	for (int i = 0; i < line.size(); ++i) {
+		const QChar c = line.at(i);
+
+		if (!quote.isNull()) {
+			if (c == quote) {
+				quote = QChar();
+			} else if (c == '\\' && quote == '"' && i + 1 < line.size()
+			           && (line.at(i + 1) == '"' || line.at(i + 1) == '\\')) {
+				argument.append(line.at(++i));
+			} else {
+				argument.append(c);
+			}
+		} else if (c == '"' || c == '\'') {
+			quote = c;
+			inArgument = true;
+		} else if (c.isSpace()) {
+			if (inArgument) {
+				ret.append(argument);
+				argument.clear();
+				inArgument = false;
+			}
+		} else {
+			argument.append(c);
+			inArgument = true;
+		}
+	}
+
+	if (inArgument) {
+		ret.append(argument);
+	}
+
+	if (ok) {
+		*ok = quote.isNull();
+	}
+
+	return ret;
+}
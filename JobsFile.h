@@ -0,0 +1,38 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef JOBSFILE_H
+#define JOBSFILE_H
+
+#include <QtCore>
+#include "Arguments.h"
+
+/*
+ * Runs the jobs listed in a text file, one command line per line
+ * (without the program name), in a thread pool.
+ * Empty lines and lines starting with '#' are ignored.
+ */
+class JobsFile
+{
+public:
+	explicit JobsFile(const Arguments &args);
+	int exec();
+	static QStringList splitCommandLine(const QString &line, bool *ok = 0);
+private:
+	const Arguments &_args;
+};
+
+#endif // JOBSFILE_H
@@ -0,0 +1,256 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Quantizer.h"
+#include "PsColor.h"
+#include <algorithm>
+#include <climits>
+
+#define STP_BIT 0x8000
+
+/*
+ * Returns the PS color with the STP bit for semi-transparent colors,
+ * or -1 for transparent colors.
+ */
+inline int Quantizer::psColor(QRgb color, const quint8 *to5Bits)
+{
+	const int alpha = qAlpha(color);
+
+	if (alpha < 64) {
+		return -1;
+	}
+
+	return to5Bits[qRed(color)]
+	        | (to5Bits[qGreen(color)] << 5)
+	        | (to5Bits[qBlue(color)] << 10)
+	        | (alpha < 192 ? STP_BIT : 0);
+}
+
+inline int Quantizer::component(quint16 color, int axis)
+{
+	if (axis == 3) {
+		// STP colors are far from opaque colors, to split them first
+		return color & STP_BIT ? 31 : 0;
+	}
+	return (color >> (5 * axis)) & 31;
+}
+
+QImage Quantizer::quantize(const QImage &image, int colorCount)
+{
+	const QImage source = image.format() == QImage::Format_ARGB32
+	        ? image
+	        : image.convertToFormat(QImage::Format_ARGB32);
+	QVector<quint32> histogram(0x10000, 0);
+	quint8 to5Bits[256];
+	bool hasTransparency = false;
+
+	for (int i = 0; i < 256; ++i) {
+		to5Bits[i] = quint8(qRound(i / COEFF_COLOR));
+	}
+
+	for (int y = 0; y < source.height(); ++y) {
+		const QRgb *pixels = (const QRgb *)source.constScanLine(y);
+
+		for (int x = 0; x < source.width(); ++x) {
+			int color = psColor(pixels[x], to5Bits);
+			if (color < 0) {
+				hasTransparency = true;
+			} else {
+				++histogram[color];
+			}
+		}
+	}
+
+	QVector<Entry> entries;
+	for (int color = 0; color < histogram.size(); ++color) {
+		if (histogram.at(color) > 0) {
+			Entry entry = { quint16(color), histogram.at(color) };
+			entries.append(entry);
+		}
+	}
+
+	// Index 0 is kept for transparent pixels
+	const int firstIndex = hasTransparency ? 1 : 0;
+	QVector<quint8> indexes(0x10000, 0);
+	QVector<QRgb> colorTable(colorCount, qRgba(0, 0, 0, 0));
+
+	if (entries.size() <= colorCount - firstIndex) {
+		// Every color fits in the palette
+		for (int i = 0; i < entries.size(); ++i) {
+			indexes[entries.at(i).color] = quint8(firstIndex + i);
+			colorTable[firstIndex + i] = toRgb(entries.at(i).color);
+		}
+	} else {
+		QVector<quint16> palette = medianCut(entries, colorCount - firstIndex);
+
+		for (int i = 0; i < palette.size(); ++i) {
+			colorTable[firstIndex + i] = toRgb(palette.at(i));
+		}
+
+		// Nearest color rather than the median cut box, for a better match
+		foreach (const Entry &entry, entries) {
+			indexes[entry.color] = quint8(firstIndex + nearest(palette, entry.color));
+		}
+	}
+
+	QImage ret(source.size(), QImage::Format_Indexed8);
+	ret.setColorTable(colorTable);
+
+	for (int y = 0; y < source.height(); ++y) {
+		const QRgb *pixels = (const QRgb *)source.constScanLine(y);
+		uchar *scanLine = ret.scanLine(y);
+
+		for (int x = 0; x < source.width(); ++x) {
+			int color = psColor(pixels[x], to5Bits);
+			scanLine[x] = color < 0 ? 0 : indexes.at(color);
+		}
+	}
+
+	return ret;
+}
+
+QVector<quint16> Quantizer::medianCut(QVector<Entry> &entries, int colorCount)
+{
+	QList<Box> boxes;
+	Box first = { 0, entries.size() };
+	boxes.append(first);
+
+	while (boxes.size() < colorCount) {
+		int bestBox = -1, bestAxis = 0;
+		quint64 bestScore = 0;
+
+		// The box with the most pixels along the longest side
+		for (int i = 0; i < boxes.size(); ++i) {
+			const Box &box = boxes.at(i);
+			if (box.end - box.begin < 2) {
+				continue;
+			}
+
+			int min[4] = { 31, 31, 31, 31 }, max[4] = { 0, 0, 0, 0 };
+			quint64 population = 0;
+
+			for (int j = box.begin; j < box.end; ++j) {
+				const Entry &entry = entries.at(j);
+				for (int axis = 0; axis < 4; ++axis) {
+					int c = component(entry.color, axis);
+					min[axis] = qMin(min[axis], c);
+					max[axis] = qMax(max[axis], c);
+				}
+				population += entry.count;
+			}
+
+			for (int axis = 0; axis < 4; ++axis) {
+				quint64 score = quint64(max[axis] - min[axis]) * population;
+				if (score > bestScore) {
+					bestScore = score;
+					bestBox = i;
+					bestAxis = axis;
+				}
+			}
+		}
+
+		if (bestBox < 0) {
+			break;
+		}
+
+		Box box = boxes.at(bestBox);
+		const int axis = bestAxis;
+		std::sort(entries.begin() + box.begin, entries.begin() + box.end,
+		          [axis](const Entry &e1, const Entry &e2) {
+			return component(e1.color, axis) < component(e2.color, axis);
+		});
+
+		quint64 population = 0, sum = 0;
+		for (int j = box.begin; j < box.end; ++j) {
+			population += entries.at(j).count;
+		}
+
+		// Split at the median pixel, both halves not empty
+		int middle = box.end - 1;
+		for (int j = box.begin; j < box.end - 1; ++j) {
+			sum += entries.at(j).count;
+			if (sum * 2 >= population) {
+				middle = j + 1;
+				break;
+			}
+		}
+
+		Box second = { middle, box.end };
+		box.end = middle;
+		boxes[bestBox] = box;
+		boxes.append(second);
+	}
+
+	QVector<quint16> palette;
+
+	foreach (const Box &box, boxes) {
+		quint64 r = 0, g = 0, b = 0, stp = 0, population = 0;
+
+		for (int j = box.begin; j < box.end; ++j) {
+			const Entry &entry = entries.at(j);
+			r += quint64(component(entry.color, 0)) * entry.count;
+			g += quint64(component(entry.color, 1)) * entry.count;
+			b += quint64(component(entry.color, 2)) * entry.count;
+			if (entry.color & STP_BIT) {
+				stp += entry.count;
+			}
+			population += entry.count;
+		}
+
+		palette.append(quint16(((r + population / 2) / population)
+		                       | (((g + population / 2) / population) << 5)
+		                       | (((b + population / 2) / population) << 10)
+		                       | (stp * 2 > population ? STP_BIT : 0)));
+	}
+
+	return palette;
+}
+
+int Quantizer::nearest(const QVector<quint16> &palette, quint16 color)
+{
+	int best = 0, bestDistance = INT_MAX;
+
+	for (int i = 0; i < palette.size(); ++i) {
+		const quint16 paletteColor = palette.at(i);
+		int distance = (paletteColor ^ color) & STP_BIT ? 3 * 32 * 32 : 0;
+
+		for (int axis = 0; axis < 3; ++axis) {
+			int d = component(paletteColor, axis) - component(color, axis);
+			distance += d * d;
+		}
+
+		if (distance < bestDistance) {
+			bestDistance = distance;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+QRgb Quantizer::toRgb(quint16 color)
+{
+	const bool stp = color & STP_BIT;
+	quint16 rgb = color & 0x7FFF;
+
+	// Opaque black is transparent on PS, use the closest color instead
+	if (rgb == 0 && !stp) {
+		rgb = 1 << 10;
+	}
+
+	QRgb ret = PsColor::fromPsColor(rgb);
+	return qRgba(qRed(ret), qGreen(ret), qBlue(ret), stp ? 127 : 255);
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef QUANTIZER_H
+#define QUANTIZER_H
+
+#include <QImage>
+
+/*
+ * Generates a palette for a truecolor image (median cut on a
+ * histogram of PS colors), with the alpha convention of exported palettes:
+ * alpha 0 is transparent (always index 0), 127 is semi-transparent (STP bit)
+ * and 255 is opaque.
+ */
+class Quantizer
+{
+public:
+	static QImage quantize(const QImage &image, int colorCount);
+private:
+	struct Entry {
+		quint16 color; // PS color, bit 15 is the STP bit
+		quint32 count;
+	};
+	struct Box {
+		int begin, end;
+	};
+
+	static int psColor(QRgb color, const quint8 *to5Bits);
+	static int component(quint16 color, int axis);
+	static QVector<quint16> medianCut(QVector<Entry> &entries, int colorCount);
+	static int nearest(const QVector<quint16> &palette, quint16 color);
+	static QRgb toRgb(quint16 color);
+};
+
+#endif // QUANTIZER_H
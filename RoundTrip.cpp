@@ -0,0 +1,196 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "RoundTrip.h"
+#include "TextureFile.h"
+#include "Stats.h"
+#include "Trace.h"
+
+#define ROUNDTRIP_MAX_OFFSETS	8
+
+class RoundTripJob : public QRunnable
+{
+public:
+	RoundTripJob(RoundTrip *roundTrip, const QString &path, const QString &format) :
+		_roundTrip(roundTrip), _path(path), _format(format)
+	{
+	}
+	void run();
+private:
+	RoundTrip *_roundTrip;
+	QString _path, _format;
+};
+
+void RoundTripJob::run()
+{
+	TraceSpan span("file", _path);
+	QFile f(_path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(_path) << f.errorString();
+		_roundTrip->addStats(_format, false, 0, 0);
+		return;
+	}
+
+	const QByteArray data = f.readAll();
+	f.close();
+
+	TextureFile *texture = TextureFile::factory(_format);
+	QByteArray saved;
+	QElapsedTimer timer;
+
+	timer.start();
+	const bool opened = texture->open(data), ok = opened && texture->save(saved);
+	const qint64 nsecs = timer.nsecsElapsed();
+
+	delete texture;
+
+	if (!opened) {
+		qWarning() << "Error: Cannot open Texture file" << QDir::toNativeSeparators(_path);
+	} else if (!ok) {
+		qWarning() << "Error: Cannot save Texture file" << QDir::toNativeSeparators(_path);
+	}
+
+	qint64 count = 0;
+	const QList<qint64> offsets = ok ? RoundTrip::mismatchOffsets(data, saved, ROUNDTRIP_MAX_OFFSETS, &count)
+	                                 : QList<qint64>();
+
+	if (ok && (count > 0 || data.size() != saved.size())) {
+		QStringList hexOffsets;
+		foreach (qint64 offset, offsets) {
+			hexOffsets.append(QString("0x%1").arg(offset, 0, 16));
+		}
+		if (count > offsets.size()) {
+			hexOffsets.append("...");
+		}
+		qWarning() << qPrintable(QString("%1: %2 bytes differ, size %3 -> %4, at %5")
+		                         .arg(QDir::toNativeSeparators(_path))
+		                         .arg(count).arg(data.size()).arg(saved.size())
+		                         .arg(hexOffsets.join(" ")));
+	}
+
+	_roundTrip->addStats(_format, ok && count == 0 && data.size() == saved.size(),
+	                     data.size(), nsecs);
+	Stats::addFile();
+}
+
+RoundTrip::RoundTrip(const Arguments &args) :
+	_args(args)
+{
+}
+
+void RoundTrip::addStats(const QString &format, bool same, qint64 bytes, qint64 nsecs)
+{
+	QMutexLocker locker(&_mutex);
+	FormatStats &stats = _stats[format];
+
+	stats.files += 1;
+	stats.mismatches += same ? 0 : 1;
+	stats.bytes += bytes;
+	stats.nsecs += nsecs;
+}
+
+/*
+ * Offsets of the first maxCount different bytes, count is set to
+ * the number of different bytes (bytes missing in one of the data included).
+ */
+QList<qint64> RoundTrip::mismatchOffsets(const QByteArray &data1, const QByteArray &data2,
+                                         int maxCount, qint64 *count)
+{
+	const char *constData1 = data1.constData(), *constData2 = data2.constData();
+	const qint64 size = qMin(data1.size(), data2.size());
+	QList<qint64> offsets;
+	qint64 pos = 0;
+
+	*count = qAbs(qint64(data1.size()) - data2.size());
+
+	// Same bytes are skipped with memcmp, by blocks
+	while (pos < size) {
+		const qint64 blockSize = qMin(qint64(4096), size - pos);
+
+		if (memcmp(constData1 + pos, constData2 + pos, blockSize) != 0) {
+			for (qint64 i = pos; i < pos + blockSize; ++i) {
+				if (constData1[i] != constData2[i]) {
+					if (offsets.size() < maxCount) {
+						offsets.append(i);
+					}
+					*count += 1;
+				}
+			}
+		}
+
+		pos += blockSize;
+	}
+
+	if (offsets.size() < maxCount && data1.size() != data2.size()) {
+		offsets.append(size);
+	}
+
+	return offsets;
+}
+
+int RoundTrip::exec()
+{
+	QThreadPool pool;
+	QElapsedTimer timer;
+	int failures = 0;
+
+	if (_args.threads() > 0) {
+		pool.setMaxThreadCount(_args.threads());
+	}
+
+	timer.start();
+
+	foreach (const QString &path, _args.paths()) {
+		const QString format = _args.inputFormat(path).toLower();
+
+		if (QDir(path).exists()) {
+			qWarning() << "Directory ignored" << path;
+			continue;
+		}
+
+		if (!TextureFile::supportedTextureFormats().contains(format)) {
+			qWarning() << "Warning: not a texture format, file ignored" << QDir::toNativeSeparators(path);
+			continue;
+		}
+
+		pool.start(new RoundTripJob(this, path, format));
+	}
+
+	pool.waitForDone();
+
+	const qint64 elapsed = timer.nsecsElapsed();
+	qint64 totalBytes = 0;
+
+	QMapIterator<QString, FormatStats> it(_stats);
+	while (it.hasNext()) {
+		it.next();
+		const FormatStats &stats = it.value();
+
+		// Throughput of one thread
+		printf("%s: %d files, %d mismatches, %.1f MB/s\n",
+		       qPrintable(it.key()), stats.files, stats.mismatches,
+		       stats.nsecs > 0 ? stats.bytes * 1000.0 / stats.nsecs : 0.0);
+
+		failures += stats.mismatches;
+		totalBytes += stats.bytes;
+	}
+
+	printf("total: %.1f MB in %.3f s, %.1f MB/s\n",
+	       totalBytes / 1000000.0, elapsed / 1000000000.0,
+	       elapsed > 0 ? totalBytes * 1000.0 / elapsed : 0.0);
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef ROUNDTRIP_H
+#define ROUNDTRIP_H
+
+#include <QtCore>
+#include "Arguments.h"
+
+/*
+ * Opens and saves again every input texture in memory,
+ * and compares the result with the original file.
+ * Files are checked in a thread pool, mismatches are reported
+ * with their offsets, then the throughput of each format.
+ */
+class RoundTrip
+{
+public:
+	explicit RoundTrip(const Arguments &args);
+	int exec();
+
+	struct FormatStats {
+		FormatStats() : files(0), mismatches(0), bytes(0), nsecs(0) {}
+		int files, mismatches;
+		qint64 bytes, nsecs;
+	};
+	void addStats(const QString &format, bool same, qint64 bytes, qint64 nsecs);
+	static QList<qint64> mismatchOffsets(const QByteArray &data1, const QByteArray &data2,
+	                                     int maxCount, qint64 *count);
+private:
+	const Arguments &_args;
+	QMap<QString, FormatStats> _stats;
+	QMutex _mutex;
+};
+
+#endif // ROUNDTRIP_H
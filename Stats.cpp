@@ -0,0 +1,146 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Stats.h"
+
+bool Stats::_enabled = false;
+QElapsedTimer Stats::_elapsed;
+QAtomicInteger<qint64> Stats::_calls[Stats::StageCount];
+QAtomicInteger<qint64> Stats::_nsecs[Stats::StageCount];
+QAtomicInteger<qint64> Stats::_bytes[Stats::StageCount];
+QAtomicInteger<qint64> Stats::_pixels[Stats::StageCount];
+QAtomicInteger<qint64> Stats::_files;
+
+void Stats::setEnabled(bool enabled)
+{
+	_enabled = enabled;
+	if (enabled) {
+		_elapsed.start();
+	}
+}
+
+void Stats::add(Stage stage, qint64 nsecs, qint64 bytes, qint64 pixels)
+{
+	_calls[stage].fetchAndAddRelaxed(1);
+	_nsecs[stage].fetchAndAddRelaxed(nsecs);
+	_bytes[stage].fetchAndAddRelaxed(bytes);
+	_pixels[stage].fetchAndAddRelaxed(pixels);
+}
+
+const char *Stats::stageName(Stage stage)
+{
+	switch (stage) {
+	case Read:            return "read";
+	case Decode:          return "decode";
+	case ColorConversion: return "color_conversion";
+	case Encode:          return "encode";
+	case ImageEncode:     return "image_encode";
+	case Transcode:       return "transcode";
+	case Write:           return "write";
+	default:              break;
+	}
+	return "";
+}
+
+QByteArray Stats::toJson()
+{
+	const double elapsed = _elapsed.nsecsElapsed() / 1000000000.0;
+	QJsonObject root, stages;
+
+	for (int i = 0; i < StageCount; ++i) {
+		QJsonObject stage;
+		stage["calls"] = double(_calls[i].load());
+		stage["seconds"] = _nsecs[i].load() / 1000000000.0;
+		stage["bytes"] = double(_bytes[i].load());
+		stage["pixels"] = double(_pixels[i].load());
+		stages[stageName(Stage(i))] = stage;
+	}
+
+	root["elapsed_seconds"] = elapsed;
+	root["files"] = double(_files.load());
+	root["files_per_second"] = elapsed > 0.0 ? _files.load() / elapsed : 0.0;
+	root["stages"] = stages;
+
+	return QJsonDocument(root).toJson();
+}
+
+/*
+ * Text format of the Prometheus node exporter (textfile collector).
+ */
+QByteArray Stats::toPrometheus()
+{
+	const double elapsed = _elapsed.nsecsElapsed() / 1000000000.0;
+	QByteArray ret;
+	const char *metrics[4][2] = {
+		{"tim_stage_calls_total", "Number of times the stage was run."},
+		{"tim_stage_seconds_total", "Time spent in the stage, for all threads."},
+		{"tim_stage_bytes_total", "Bytes processed by the stage."},
+		{"tim_stage_pixels_total", "Pixels processed by the stage."}
+	};
+	QAtomicInteger<qint64> *values[4] = {_calls, _nsecs, _bytes, _pixels};
+
+	for (int m = 0; m < 4; ++m) {
+		ret.append(QString("# HELP %1 %2\n# TYPE %1 counter\n")
+		           .arg(metrics[m][0], metrics[m][1]).toLatin1());
+		for (int i = 0; i < StageCount; ++i) {
+			const qint64 value = values[m][i].load();
+			ret.append(QString("%1{stage=\"%2\"} %3\n")
+			           .arg(metrics[m][0], stageName(Stage(i)))
+			           .arg(values[m] == _nsecs ? QString::number(value / 1000000000.0, 'f', 9)
+			                                    : QString::number(value))
+			           .toLatin1());
+		}
+	}
+
+	ret.append(QString("# HELP tim_files_total Number of input files.\n"
+	                   "# TYPE tim_files_total counter\n"
+	                   "tim_files_total %1\n"
+	                   "# HELP tim_elapsed_seconds Duration of the run.\n"
+	                   "# TYPE tim_elapsed_seconds gauge\n"
+	                   "tim_elapsed_seconds %2\n"
+	                   "# HELP tim_files_per_second Input files per second.\n"
+	                   "# TYPE tim_files_per_second gauge\n"
+	                   "tim_files_per_second %3\n")
+	           .arg(_files.load())
+	           .arg(elapsed, 0, 'f', 9)
+	           .arg(elapsed > 0.0 ? _files.load() / elapsed : 0.0, 0, 'f', 3)
+	           .toLatin1());
+
+	return ret;
+}
+
+/*
+ * Prometheus format if the file name ends with ".prom", JSON otherwise.
+ */
+bool Stats::save(const QString &path)
+{
+	QFile f(path);
+
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(path) << f.errorString();
+		return false;
+	}
+
+	const QByteArray data = path.endsWith(".prom", Qt::CaseInsensitive)
+	        ? toPrometheus() : toJson();
+
+	if (f.write(data) != data.size()) {
+		qWarning() << "Error: Cannot save" << QDir::toNativeSeparators(path) << f.errorString();
+		return false;
+	}
+
+	return true;
+}
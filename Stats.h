@@ -0,0 +1,101 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef STATS_H
+#define STATS_H
+
+#include <QtCore>
+#include "Trace.h"
+
+/*
+ * Cumulative time, bytes and pixels of each processing stage,
+ * for all threads. Disabled by default: a StatsTimer then only
+ * costs a boolean test.
+ */
+class Stats
+{
+public:
+	enum Stage {
+		Read,
+		Decode,
+		ColorConversion,
+		Encode,
+		ImageEncode,
+		Transcode,
+		Write,
+		StageCount
+	};
+
+	// Must be called before starting the worker threads
+	static void setEnabled(bool enabled);
+	static inline bool isEnabled() {
+		return _enabled;
+	}
+	static void add(Stage stage, qint64 nsecs, qint64 bytes, qint64 pixels);
+	static inline void addFile() {
+		if (_enabled) {
+			_files.fetchAndAddRelaxed(1);
+		}
+	}
+	static bool save(const QString &path);
+	static const char *stageName(Stage stage);
+private:
+	static QByteArray toJson();
+	static QByteArray toPrometheus();
+
+	static bool _enabled;
+	static QElapsedTimer _elapsed;
+	static QAtomicInteger<qint64> _calls[StageCount], _nsecs[StageCount],
+	        _bytes[StageCount], _pixels[StageCount];
+	static QAtomicInteger<qint64> _files;
+};
+
+/*
+ * Adds the time between its construction and its destruction to a stage,
+ * and to the trace.
+ */
+class StatsTimer
+{
+public:
+	inline explicit StatsTimer(Stats::Stage stage, qint64 bytes = 0, qint64 pixels = 0) :
+		_stage(stage), _bytes(bytes), _pixels(pixels), _enabled(Stats::isEnabled()),
+		_span(Stats::stageName(stage))
+	{
+		if (_enabled) {
+			_timer.start();
+		}
+	}
+	inline ~StatsTimer() {
+		if (_enabled) {
+			Stats::add(_stage, _timer.nsecsElapsed(), _bytes, _pixels);
+		}
+	}
+	inline void setBytes(qint64 bytes) {
+		_bytes = bytes;
+	}
+	inline void setPixels(qint64 pixels) {
+		_pixels = pixels;
+	}
+private:
+	Q_DISABLE_COPY(StatsTimer)
+	Stats::Stage _stage;
+	qint64 _bytes, _pixels;
+	bool _enabled;
+	QElapsedTimer _timer;
+	TraceSpan _span;
+};
+
+#endif // STATS_H
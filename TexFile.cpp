@@ -17,6 +17,202 @@
  ****************************************************************************/
 #include "TexFile.h"
 #include "PsColor.h"
+#include "Stats.h"
+#include <cstddef>
+
+/*
+ * Every TexStruct field, in file order, with the first version it
+ * appears in. imageWidth and imageHeight come from the image and are
+ * not written to the meta data.
+ */
+struct TexField {
+	const char *name;
+	quint32 offset;
+	quint8 width;
+	quint8 minVersion;
+	bool inMeta;
+};
+
+#define TEX_FIELD(name, minVersion, inMeta) \
+	{ #name, quint32(offsetof(TexStruct, name)), quint8(sizeof(TexStruct::name)), minVersion, inMeta }
+
+static constexpr TexField texFields[] = {
+	TEX_FIELD(version, 1, true),
+	TEX_FIELD(unknown1, 1, true),
+	TEX_FIELD(hasColorKey, 1, true),
+	TEX_FIELD(unknown2, 1, true),
+	TEX_FIELD(unknown3, 1, true),
+	TEX_FIELD(minBitsPerColor, 1, true),
+	TEX_FIELD(maxBitsPerColor, 1, true),
+	TEX_FIELD(minAlphaBits, 1, true),
+	TEX_FIELD(maxAlphaBits, 1, true),
+	TEX_FIELD(minBitsPerPixel, 1, true),
+	TEX_FIELD(maxBitsPerPixel, 1, true),
+	TEX_FIELD(unknown4, 1, true),
+	TEX_FIELD(nbPalettes, 1, true),
+	TEX_FIELD(nbColorsPerPalette1, 1, true),
+	TEX_FIELD(bitDepth, 1, true),
+	TEX_FIELD(imageWidth, 1, false),
+	TEX_FIELD(imageHeight, 1, false),
+	TEX_FIELD(pitch, 1, true),
+	TEX_FIELD(unknown5, 1, true),
+	TEX_FIELD(hasPal, 1, true),
+	TEX_FIELD(bitsPerIndex, 1, true),
+	TEX_FIELD(indexedTo8bit, 1, true),
+	TEX_FIELD(paletteSize, 1, true),
+	TEX_FIELD(nbColorsPerPalette2, 1, true),
+	TEX_FIELD(runtimeData1, 1, true),
+	TEX_FIELD(bitsPerPixel, 1, true),
+	TEX_FIELD(bytesPerPixel, 1, true),
+	TEX_FIELD(nbRedBits1, 1, true),
+	TEX_FIELD(nbGreenBits1, 1, true),
+	TEX_FIELD(nbBlueBits1, 1, true),
+	TEX_FIELD(nbAlphaBits1, 1, true),
+	TEX_FIELD(redBitmask, 1, true),
+	TEX_FIELD(greenBitmask, 1, true),
+	TEX_FIELD(blueBitmask, 1, true),
+	TEX_FIELD(alphaBitmask, 1, true),
+	TEX_FIELD(redShift, 1, true),
+	TEX_FIELD(greenShift, 1, true),
+	TEX_FIELD(blueShift, 1, true),
+	TEX_FIELD(alphaShift, 1, true),
+	TEX_FIELD(nbRedBits2, 1, true),
+	TEX_FIELD(nbGreenBits2, 1, true),
+	TEX_FIELD(nbBlueBits2, 1, true),
+	TEX_FIELD(nbAlphaBits2, 1, true),
+	TEX_FIELD(redMax, 1, true),
+	TEX_FIELD(greenMax, 1, true),
+	TEX_FIELD(blueMax, 1, true),
+	TEX_FIELD(alphaMax, 1, true),
+	TEX_FIELD(hasColorKeyArray, 1, true),
+	TEX_FIELD(runtimeData2, 1, true),
+	TEX_FIELD(referenceAlpha, 1, true),
+	TEX_FIELD(runtimeData3, 1, true),
+	TEX_FIELD(unknown6, 1, true),
+	TEX_FIELD(paletteIndex, 1, true),
+	TEX_FIELD(runtimeData4, 1, true),
+	TEX_FIELD(runtimeData5, 1, true),
+	TEX_FIELD(unknown7, 1, true),
+	TEX_FIELD(unknown8, 1, true),
+	TEX_FIELD(unknown9, 1, true),
+	TEX_FIELD(unknown10, 1, true),
+	TEX_FIELD(unknown11, 2, true),
+};
+
+#undef TEX_FIELD
+
+#define TEX_FIELD_COUNT	int(sizeof(texFields) / sizeof(TexField))
+#define TEX_FIELD_SLOTS	256
+// First seed without collision, found by isPerfectSeed()
+#define TEX_FIELD_SEED	1159
+
+static_assert(TEX_FIELD_COUNT * sizeof(quint32) == sizeof(TexStruct),
+              "texFields must list every TexStruct field");
+
+/* FNV-1a, mixed a bit more to spread the high bits on few slots */
+static constexpr quint32 texFieldHashStep(quint32 h, quint32 c)
+{
+	return (h ^ (c & 0xFF)) * 16777619u;
+}
+
+static constexpr quint32 texFieldHashEnd(quint32 h)
+{
+	return (h ^ (h >> 15)) % TEX_FIELD_SLOTS;
+}
+
+static constexpr int texFieldNameSize(const char *name)
+{
+	int size = 0;
+	while (name[size] != '\0') {
+		++size;
+	}
+	return size;
+}
+
+static constexpr quint32 texFieldHash(const char *name, quint32 seed)
+{
+	quint32 h = 2166136261u ^ seed;
+	for (int i = 0; name[i] != '\0'; ++i) {
+		h = texFieldHashStep(h, quint8(name[i]));
+	}
+	return texFieldHashEnd(h);
+}
+
+static quint32 texFieldHash(const QString &name, quint32 seed)
+{
+	const QChar *data = name.constData();
+	const int size = name.size();
+	quint32 h = 2166136261u ^ seed;
+	for (int i = 0; i < size; ++i) {
+		h = texFieldHashStep(h, data[i].unicode());
+	}
+	return texFieldHashEnd(h);
+}
+
+static constexpr bool isPerfectSeed(quint32 seed)
+{
+	bool used[TEX_FIELD_SLOTS] = {};
+	for (int i = 0; i < TEX_FIELD_COUNT; ++i) {
+		const quint32 slot = texFieldHash(texFields[i].name, seed);
+		if (used[slot]) {
+			return false;
+		}
+		used[slot] = true;
+	}
+	return true;
+}
+
+static_assert(isPerfectSeed(TEX_FIELD_SEED),
+              "TEX_FIELD_SEED must be recomputed when texFields changes");
+
+struct TexFieldSlots {
+	qint8 index[TEX_FIELD_SLOTS];
+};
+
+static constexpr TexFieldSlots texFieldSlots()
+{
+	TexFieldSlots ret = {};
+	for (int i = 0; i < TEX_FIELD_SLOTS; ++i) {
+		ret.index[i] = -1;
+	}
+	for (int i = 0; i < TEX_FIELD_COUNT; ++i) {
+		ret.index[texFieldHash(texFields[i].name, TEX_FIELD_SEED)] = qint8(i);
+	}
+	return ret;
+}
+
+static constexpr TexFieldSlots texFieldsByName = texFieldSlots();
+
+/*
+ * Returns the field named name, or nullptr.
+ * A slot can be reached by an unknown name, so the name is compared.
+ */
+static const TexField *texField(const QString &name)
+{
+	const int index = texFieldsByName.index[texFieldHash(name, TEX_FIELD_SEED)];
+	if (index < 0) {
+		return nullptr;
+	}
+
+	const TexField *field = &texFields[index];
+	if (name.size() != texFieldNameSize(field->name) || name != QLatin1String(field->name)) {
+		return nullptr;
+	}
+
+	return field;
+}
+
+static inline quint32 texFieldValue(const TexStruct &header, const TexField &field)
+{
+	quint32 value = 0;
+	memcpy(&value, (const char *)&header + field.offset, field.width);
+	return value;
+}
+
+static inline void setTexFieldValue(TexStruct &header, const TexField &field, quint32 value)
+{
+	memcpy((char *)&header + field.offset, &value, field.width);
+}
 
 TexFile::TexFile(Version version, bool hasAlpha, bool fourBitsPerIndex) :
       TextureFile()
@@ -44,37 +240,61 @@ TexFile::TexFile(const TextureFile &textureFile) :
 	setHeader(One, true, textureFile.depth() == 4);
 }
 
-bool TexFile::open(const QByteArray &data)
+/*
+ * Reads the header from the start of a file of fileSize bytes,
+ * the sections it describes must fill the file.
+ */
+bool TexFile::openHeader(const QByteArray &data, qint64 fileSize, TexStruct &header,
+                         quint32 *headerSize)
 {
-	const char *constData = data.constData();
-	quint32 w, h, headerSize, paletteSectionSize, imageSectionSize, colorKeySectionSize;
+	quint32 size;
 
 	if((quint32)data.size() < sizeof(TexStruct)) {
 		qWarning() << "tex size too short!";
 		return false;
 	}
 
-	memcpy(&_header, constData, sizeof(TexStruct));
+	memcpy(&header, data.constData(), sizeof(TexStruct));
 
-	if(_header.version == 1) {
-		headerSize = sizeof(TexStruct) - 4;
-	} else if(_header.version == 2) {
-		headerSize = sizeof(TexStruct);
+	if(header.version == 1) {
+		size = sizeof(TexStruct) - 4;
+	} else if(header.version == 2) {
+		size = sizeof(TexStruct);
 	} else {
 		qWarning() << "unknown tex version!";
 		return false;
 	}
 
+	const quint32 paletteSectionSize = header.nbPalettes > 0 ? header.paletteSize * 4 : 0,
+	        imageSectionSize = header.imageWidth * header.imageHeight * header.bytesPerPixel,
+	        colorKeySectionSize = header.hasColorKeyArray ? header.nbPalettes : 0;
+
+	if(fileSize != qint64(size) + paletteSectionSize + imageSectionSize + colorKeySectionSize) {
+		qWarning() << "tex invalid size!" << fileSize << (size + paletteSectionSize + imageSectionSize + colorKeySectionSize);
+		return false;
+	}
+
+	if(headerSize) {
+		*headerSize = size;
+	}
+
+	return true;
+}
+
+bool TexFile::open(const QByteArray &data)
+{
+	StatsTimer timer(Stats::Decode, data.size());
+	const char *constData = data.constData();
+	quint32 w, h, headerSize, paletteSectionSize, imageSectionSize;
+
+	if(!openHeader(data, data.size(), _header, &headerSize)) {
+		return false;
+	}
+
 	w = _header.imageWidth;
 	h = _header.imageHeight;
 	paletteSectionSize = _header.nbPalettes > 0 ? _header.paletteSize * 4 : 0;
 	imageSectionSize = w * h * _header.bytesPerPixel;
-	colorKeySectionSize = _header.hasColorKeyArray ? _header.nbPalettes : 0;
-
-	if((quint32)data.size() != headerSize + paletteSectionSize + imageSectionSize + colorKeySectionSize) {
-		qWarning() << "tex invalid size!" << data.size() << (headerSize + paletteSectionSize + imageSectionSize + colorKeySectionSize);
-		return false;
-	}
 
 	quint32 i;
 
@@ -136,11 +356,15 @@ bool TexFile::open(const QByteArray &data)
 		}
 	}
 
+	timer.setPixels(w * h);
 	return true;
 }
 
 bool TexFile::save(QByteArray &data) const
 {
+	StatsTimer timer(Stats::Encode, 0, _image.width() * _image.height());
+	const int start = data.size();
+
 	data.append((char *)&_header, _header.version>=2 ? sizeof(TexStruct) : sizeof(TexStruct) - 4);
 
 	// qDebug() << "texSize header" << data.size();
@@ -183,152 +407,139 @@ bool TexFile::save(QByteArray &data) const
 		// qDebug() << "texSize data" << data.size();
 	}
 
+	timer.setBytes(data.size() - start);
 	return true;
 }
 
 void TexFile::setDepth(quint8 depth)
 {
+	const bool wasPaletted = isPaletted();
+
 	TextureFile::setDepth(depth);
+
+	if (wasPaletted && isPaletted()) {
+		// Keep the other fields, only the palette format changes
+		_header.bitDepth = depth;
+		setPaletteSize(paletteSize());
+	} else {
+		setHeader(Version(_header.version), _header.unknown2, depth == 4);
+	}
 }
 
-void TexFile::setHeader(Version version, bool hasAlpha, bool fourBitsPerIndex)
+void TexFile::setPaletteSize(const QSize &size)
 {
-	_header = TexStruct();
-	_header.version = quint32(version);
-	// _header.unknown1 = 0;
-	_header.hasColorKey = !colorKeyArray.isEmpty();
-	_header.unknown2 = hasAlpha;
-	// _header.unknown3 = 0; // FIXME: find what is that
-	_header.minBitsPerColor = 4;
-	_header.maxBitsPerColor = 8;
-	_header.minAlphaBits = hasAlpha ? 4 : 0;
-	_header.maxAlphaBits = 8;
-	_header.minBitsPerPixel = !isPaletted() ? 32 : 8;
-	_header.maxBitsPerPixel = 32;
-	// _header.unknown4 = 0;
+	Q_UNUSED(size);
+
 	_header.nbPalettes = colorTableCount();
-	if (isPaletted()) {
-		_header.nbColorsPerPalette1 = !fourBitsPerIndex ? 256 : 16;
+	_header.nbColorsPerPalette1 = colorPerPal();
+	if (_header.nbColorsPerPalette2 != 0) {
+		_header.nbColorsPerPalette2 = _header.nbColorsPerPalette1;
 	}
-	_header.bitDepth = !isPaletted() ? 16 : (!fourBitsPerIndex ? 8 : 4);
-	_header.imageWidth = _image.width();
-	_header.imageHeight = _image.height();
-	// _header.pitch = 0;
-	// _header.unknown5 = 0;
-	_header.hasPal = isPaletted();
-	_header.bitsPerIndex = isPaletted() ? 8 : 0;
-	_header.indexedTo8bit = isPaletted();
-	_header.paletteSize = colorTableCount() * _header.nbColorsPerPalette1;
-	_header.nbColorsPerPalette2 = _header.nbColorsPerPalette1;
-	// _header.runtimeData1 = 0;
-	_header.bitsPerPixel = !isPaletted() ? 16 : 8;
-	_header.bytesPerPixel = !isPaletted() ? 2 : 1;
+	_header.paletteSize = _header.nbPalettes * _header.nbColorsPerPalette1;
+}
+
+void TexFile::setHeader(Version version, bool hasAlpha, bool fourBitsPerIndex)
+{
+	_header = defaultHeader(version, hasAlpha, fourBitsPerIndex, colorTableCount(),
+	                        _image.width(), _image.height(), !colorKeyArray.isEmpty());
+}
+
+TexStruct TexFile::defaultHeader(Version version, bool hasAlpha, bool fourBitsPerIndex,
+                                 quint32 nbPalettes, quint32 width, quint32 height,
+                                 bool hasColorKey)
+{
+	const bool paletted = nbPalettes > 0;
+	TexStruct header = TexStruct();
+	header.version = quint32(version);
+	// header.unknown1 = 0;
+	header.hasColorKey = hasColorKey;
+	header.unknown2 = hasAlpha;
+	// header.unknown3 = 0; // FIXME: find what is that
+	header.minBitsPerColor = 4;
+	header.maxBitsPerColor = 8;
+	header.minAlphaBits = hasAlpha ? 4 : 0;
+	header.maxAlphaBits = 8;
+	header.minBitsPerPixel = !paletted ? 32 : 8;
+	header.maxBitsPerPixel = 32;
+	// header.unknown4 = 0;
+	header.nbPalettes = nbPalettes;
+	if (paletted) {
+		header.nbColorsPerPalette1 = !fourBitsPerIndex ? 256 : 16;
+	}
+	header.bitDepth = !paletted ? 16 : (!fourBitsPerIndex ? 8 : 4);
+	header.imageWidth = width;
+	header.imageHeight = height;
+	// header.pitch = 0;
+	// header.unknown5 = 0;
+	header.hasPal = paletted;
+	header.bitsPerIndex = paletted ? 8 : 0;
+	header.indexedTo8bit = paletted;
+	header.paletteSize = nbPalettes * header.nbColorsPerPalette1;
+	header.nbColorsPerPalette2 = header.nbColorsPerPalette1;
+	// header.runtimeData1 = 0;
+	header.bitsPerPixel = !paletted ? 16 : 8;
+	header.bytesPerPixel = !paletted ? 2 : 1;
 	// Pixel format
-	if (!isPaletted()) {
-		_header.nbRedBits1 = 5;
-		_header.nbGreenBits1 = 5;
-		_header.nbBlueBits1 = 5;
-		_header.nbAlphaBits1 = 1;
-		_header.redBitmask = 0x1F;
-		_header.greenBitmask = 0x3E0;
-		_header.blueBitmask = 0x7C00;
-		_header.alphaBitmask = 0x8000;
-		_header.redShift = 0;
-		_header.greenShift = 5;
-		_header.blueShift = 10;
-		_header.alphaShift = 15;
-		_header.nbRedBits2 = 3;
-		_header.nbGreenBits2 = 3;
-		_header.nbBlueBits2 = 3;
-		_header.nbAlphaBits2 = 7;
-		_header.redMax = 31;
-		_header.greenMax = 31;
-		_header.blueMax = 31;
-		_header.alphaMax = 1;
+	if (!paletted) {
+		header.nbRedBits1 = 5;
+		header.nbGreenBits1 = 5;
+		header.nbBlueBits1 = 5;
+		header.nbAlphaBits1 = 1;
+		header.redBitmask = 0x1F;
+		header.greenBitmask = 0x3E0;
+		header.blueBitmask = 0x7C00;
+		header.alphaBitmask = 0x8000;
+		header.redShift = 0;
+		header.greenShift = 5;
+		header.blueShift = 10;
+		header.alphaShift = 15;
+		header.nbRedBits2 = 3;
+		header.nbGreenBits2 = 3;
+		header.nbBlueBits2 = 3;
+		header.nbAlphaBits2 = 7;
+		header.redMax = 31;
+		header.greenMax = 31;
+		header.blueMax = 31;
+		header.alphaMax = 1;
 	}
 	// /Pixel format
-	// _header.hasColorKeyArray = 0;
-	// _header.runtimeData2 = 0;
-	_header.referenceAlpha = 255;
-	_header.runtimeData3 = 4;
-	// _header.unknown6 = 0;
-	// _header.paletteIndex = 0;
-	// _header.runtimeData4 = 0;
-	// _header.runtimeData5 = 0;
-	// _header.unknown7 = 0; // FIXME: find what is that
-	// _header.unknown8 = 0; // FIXME: find what is that
-	// _header.unknown9 = 0; // FIXME: find what is that
-	// _header.unknown10 = 0; // FIXME: find what is that
-
-	if (_header.version >= 2) {
-		// _header.unknown11 = 0; // FIXME: find what is that
+	// header.hasColorKeyArray = 0;
+	// header.runtimeData2 = 0;
+	header.referenceAlpha = 255;
+	header.runtimeData3 = 4;
+	// header.unknown6 = 0;
+	// header.paletteIndex = 0;
+	// header.runtimeData4 = 0;
+	// header.runtimeData5 = 0;
+	// header.unknown7 = 0; // FIXME: find what is that
+	// header.unknown8 = 0; // FIXME: find what is that
+	// header.unknown9 = 0; // FIXME: find what is that
+	// header.unknown10 = 0; // FIXME: find what is that
+
+	if (header.version >= 2) {
+		// header.unknown11 = 0; // FIXME: find what is that
 	}
+
+	return header;
 }
 
 ExtraData TexFile::extraData() const
+{
+	return extraDataFromHeader(_header);
+}
+
+/*
+ * Header fields, without opening the texture.
+ */
+ExtraData TexFile::extraDataFromHeader(const TexStruct &header)
 {
 	QMap<QString, QVariant> ret;
 
-	ret["version"] = _header.version;
-	ret["unknown1"] = _header.unknown1;
-	ret["hasColorKey"] = _header.hasColorKey;
-	ret["unknown2"] = _header.unknown2;
-	ret["unknown3"] = _header.unknown3;
-	ret["minBitsPerColor"] = _header.minBitsPerColor;
-	ret["maxBitsPerColor"] = _header.maxBitsPerColor;
-	ret["minAlphaBits"] = _header.minAlphaBits;
-	ret["maxAlphaBits"] = _header.maxAlphaBits;
-	ret["minBitsPerPixel"] = _header.minBitsPerPixel;
-	ret["maxBitsPerPixel"] = _header.maxBitsPerPixel;
-	ret["unknown4"] = _header.unknown4;
-	ret["nbPalettes"] = _header.nbPalettes;
-	ret["nbColorsPerPalette1"] = _header.nbColorsPerPalette1;
-	ret["bitDepth"] = _header.bitDepth;
-	ret["pitch"] = _header.pitch;
-	ret["unknown5"] = _header.unknown5;
-	ret["hasPal"] = _header.hasPal;
-	ret["bitsPerIndex"] = _header.bitsPerIndex;
-	ret["indexedTo8bit"] = _header.indexedTo8bit;
-	ret["paletteSize"] = _header.paletteSize;
-	ret["nbColorsPerPalette2"] = _header.nbColorsPerPalette2;
-	ret["runtimeData1"] = _header.runtimeData1;
-	ret["bitsPerPixel"] = _header.bitsPerPixel;
-	ret["bytesPerPixel"] = _header.bytesPerPixel;
-	ret["nbRedBits1"] = _header.nbRedBits1;
-	ret["nbGreenBits1"] = _header.nbGreenBits1;
-	ret["nbBlueBits1"] = _header.nbBlueBits1;
-	ret["nbAlphaBits1"] = _header.nbAlphaBits1;
-	ret["redBitmask"] = _header.redBitmask;
-	ret["greenBitmask"] = _header.greenBitmask;
-	ret["blueBitmask"] = _header.blueBitmask;
-	ret["alphaBitmask"] = _header.alphaBitmask;
-	ret["redShift"] = _header.redShift;
-	ret["greenShift"] = _header.greenShift;
-	ret["blueShift"] = _header.blueShift;
-	ret["alphaShift"] = _header.alphaShift;
-	ret["nbRedBits2"] = _header.nbRedBits2;
-	ret["nbGreenBits2"] = _header.nbGreenBits2;
-	ret["nbBlueBits2"] = _header.nbBlueBits2;
-	ret["nbAlphaBits2"] = _header.nbAlphaBits2;
-	ret["redMax"] = _header.redMax;
-	ret["greenMax"] = _header.greenMax;
-	ret["blueMax"] = _header.blueMax;
-	ret["alphaMax"] = _header.alphaMax;
-	ret["hasColorKeyArray"] = _header.hasColorKeyArray;
-	ret["runtimeData2"] = _header.runtimeData2;
-	ret["referenceAlpha"] = _header.referenceAlpha;
-	ret["runtimeData3"] = _header.runtimeData3;
-	ret["unknown6"] = _header.unknown6;
-	ret["paletteIndex"] = _header.paletteIndex;
-	ret["runtimeData4"] = _header.runtimeData4;
-	ret["runtimeData5"] = _header.runtimeData5;
-	ret["unknown7"] = _header.unknown7;
-	ret["unknown8"] = _header.unknown8;
-	ret["unknown9"] = _header.unknown9;
-	ret["unknown10"] = _header.unknown10;
-
-	if (_header.version >= 2) {
-		ret["unknown11"] = _header.unknown11;
+	for (int i = 0; i < TEX_FIELD_COUNT; ++i) {
+		const TexField &field = texFields[i];
+		if (field.inMeta && header.version >= field.minVersion) {
+			ret.insert(QLatin1String(field.name), texFieldValue(header, field));
+		}
 	}
 
 	return ExtraData(ret);
@@ -336,79 +547,43 @@ ExtraData TexFile::extraData() const
 
 bool TexFile::setExtraData(const ExtraData &extraData)
 {
-	bool ok;
+	return headerFromExtraData(extraData, colorTableCount(), _image.width(), _image.height(),
+	                           !colorKeyArray.isEmpty(), _header);
+}
+
+bool TexFile::headerFromExtraData(const ExtraData &extraData, quint32 nbPalettes,
+                                  quint32 width, quint32 height, bool hasColorKey,
+                                  TexStruct &header)
+{
+	bool ok = true;
 	QMap<QString, QVariant> fields = extraData.fields();
 	setExtraDataFieldUsed(fields);
 
-	_header.version = 1;
+	header.version = 1;
 	quint32 hasAlpha = 0;
 	quint32 fourBitsPerIndex = 0;
-	setExtraDataField(_header.version, "version");
+	setExtraDataField(header.version, "version");
 	setExtraDataField(hasAlpha, "hasAlpha");
 	setExtraDataField(fourBitsPerIndex, "fourBitsPerIndex");
 
 	// Set default values
-	setHeader(Version(_header.version), hasAlpha, fourBitsPerIndex);
-
-	setExtraDataField(_header.unknown1, "unknown1");
-	setExtraDataField(_header.unknown2, "unknown2");
-	setExtraDataField(_header.hasColorKey, "hasColorKey");
-	setExtraDataField(_header.unknown3, "unknown3");
-	setExtraDataField(_header.minBitsPerColor, "minBitsPerColor");
-	setExtraDataField(_header.maxBitsPerColor, "maxBitsPerColor");
-	setExtraDataField(_header.minAlphaBits, "minAlphaBits");
-	setExtraDataField(_header.maxAlphaBits, "maxAlphaBits");
-	setExtraDataField(_header.minBitsPerPixel, "minBitsPerPixel");
-	setExtraDataField(_header.maxBitsPerPixel, "maxBitsPerPixel");
-	setExtraDataField(_header.unknown4, "unknown4");
-	setExtraDataField(_header.nbPalettes, "nbPalettes");
-	setExtraDataField(_header.nbColorsPerPalette1, "nbColorsPerPalette1");
-	setExtraDataField(_header.bitDepth, "bitDepth");
-	setExtraDataField(_header.pitch, "pitch");
-	setExtraDataField(_header.unknown5, "unknown5");
-	setExtraDataField(_header.hasPal, "hasPal");
-	setExtraDataField(_header.bitsPerIndex, "bitsPerIndex");
-	setExtraDataField(_header.indexedTo8bit, "indexedTo8bit");
-	setExtraDataField(_header.paletteSize, "paletteSize");
-	setExtraDataField(_header.nbColorsPerPalette2, "nbColorsPerPalette2");
-	setExtraDataField(_header.runtimeData1, "runtimeData1");
-	setExtraDataField(_header.bitsPerPixel, "bitsPerPixel");
-	setExtraDataField(_header.bytesPerPixel, "bytesPerPixel");
-	setExtraDataField(_header.nbRedBits1, "nbRedBits1");
-	setExtraDataField(_header.nbGreenBits1, "nbGreenBits1");
-	setExtraDataField(_header.nbBlueBits1, "nbBlueBits1");
-	setExtraDataField(_header.nbAlphaBits1, "nbAlphaBits1");
-	setExtraDataField(_header.redBitmask, "redBitmask");
-	setExtraDataField(_header.greenBitmask, "greenBitmask");
-	setExtraDataField(_header.blueBitmask, "blueBitmask");
-	setExtraDataField(_header.alphaBitmask, "alphaBitmask");
-	setExtraDataField(_header.redShift, "redShift");
-	setExtraDataField(_header.greenShift, "greenShift");
-	setExtraDataField(_header.blueShift, "blueShift");
-	setExtraDataField(_header.alphaShift, "alphaShift");
-	setExtraDataField(_header.nbRedBits2, "nbRedBits2");
-	setExtraDataField(_header.nbGreenBits2, "nbGreenBits2");
-	setExtraDataField(_header.nbBlueBits2, "nbBlueBits2");
-	setExtraDataField(_header.nbAlphaBits2, "nbAlphaBits2");
-	setExtraDataField(_header.redMax, "redMax");
-	setExtraDataField(_header.greenMax, "greenMax");
-	setExtraDataField(_header.blueMax, "blueMax");
-	setExtraDataField(_header.alphaMax, "alphaMax");
-	setExtraDataField(_header.hasColorKeyArray, "hasColorKeyArray");
-	setExtraDataField(_header.runtimeData2, "runtimeData2");
-	setExtraDataField(_header.referenceAlpha, "referenceAlpha");
-	setExtraDataField(_header.runtimeData3, "runtimeData3");
-	setExtraDataField(_header.unknown6, "unknown6");
-	setExtraDataField(_header.paletteIndex, "paletteIndex");
-	setExtraDataField(_header.runtimeData4, "runtimeData4");
-	setExtraDataField(_header.runtimeData5, "runtimeData5");
-	setExtraDataField(_header.unknown7, "unknown7");
-	setExtraDataField(_header.unknown8, "unknown8");
-	setExtraDataField(_header.unknown9, "unknown9");
-	setExtraDataField(_header.unknown10, "unknown10");
-
-	if (_header.version >= 2) {
-		setExtraDataField(_header.unknown11, "unknown11");
+	header = defaultHeader(Version(header.version), hasAlpha, fourBitsPerIndex,
+	                       nbPalettes, width, height, hasColorKey);
+
+	QMapIterator<QString, QVariant> it(fields);
+	while (it.hasNext()) {
+		it.next();
+		const TexField *field = texField(it.key());
+
+		if (field == nullptr || !field->inMeta || header.version < field->minVersion) {
+			continue;
+		}
+
+		const quint32 value = it.value().toUInt(&ok);
+		if (!ok) {
+			return false;
+		}
+		setTexFieldValue(header, *field, value);
 	}
 
 	// TODO: colorKeyArray
@@ -418,34 +593,14 @@ bool TexFile::setExtraData(const ExtraData &extraData)
 
 void TexFile::debug()
 {
-	TexStruct h = _header;
-
 	QFile f("debugTex.txt");
 	f.open(QIODevice::WriteOnly | QIODevice::Truncate);
-	f.write(QString("version= %1 | unknown1= %2 | hasColorKey= %3 | unknown2= %4 | unknown3= %5\n")
-	            .arg(h.version).arg(h.unknown1).arg(h.hasColorKey).arg(h.unknown2).arg(h.unknown3).toLatin1());
-	f.write(QString("minBitsPerColor= %1 | maxBitsPerColor= %2 | minAlphaBits= %3 | maxAlphaBits= %4 | minBitsPerPixel= %5\n")
-	            .arg(h.minBitsPerColor).arg(h.maxBitsPerColor).arg(h.minAlphaBits).arg(h.maxAlphaBits).arg(h.minBitsPerPixel).toLatin1());
-	f.write(QString("maxBitsPerPixel= %1 | unknown4= %2 | nbPalettes= %3 | nbColorsPerPalette1= %4 | bitDepth= %5\n")
-	            .arg(h.maxBitsPerPixel).arg(h.unknown4).arg(h.nbPalettes).arg(h.nbColorsPerPalette1).arg(h.bitDepth).toLatin1());
-	f.write(QString("imageWidth= %1 | imageHeight= %2 | pitch= %3 | unknown5= %4 | hasPal= %5\n")
-	            .arg(h.imageWidth).arg(h.imageHeight).arg(h.pitch).arg(h.unknown5).arg(h.hasPal).toLatin1());
-	f.write(QString("bitsPerIndex= %1 | indexedTo8bit= %2 | paletteSize= %3 | nbColorsPerPalette2= %4 | runtimeData1= %5\n")
-	            .arg(h.bitsPerIndex).arg(h.indexedTo8bit).arg(h.paletteSize).arg(h.nbColorsPerPalette2).arg(h.runtimeData1).toLatin1());
-	f.write(QString("bitsPerPixel= %1 | bytesPerPixel= %2 | nbRedBits1= %3 | nbGreenBits1= %4 | nbBlueBits1= %5\n")
-	            .arg(h.bitsPerPixel).arg(h.bytesPerPixel).arg(h.nbRedBits1).arg(h.nbGreenBits1).arg(h.nbBlueBits1).toLatin1());
-	f.write(QString("nbAlphaBits1= %1 | redBitmask= %2 | greenBitmask= %3 | blueBitmask= %4 | alphaBitmask= %5\n")
-	            .arg(h.nbAlphaBits1).arg(h.redBitmask).arg(h.greenBitmask).arg(h.blueBitmask).arg(h.alphaBitmask).toLatin1());
-	f.write(QString("redShift= %1 | greenShift= %2 | blueShift= %3 | alphaShift= %4 | nbRedBits2= %5\n")
-	            .arg(h.redShift).arg(h.greenShift).arg(h.blueShift).arg(h.alphaShift).arg(h.nbRedBits2).toLatin1());
-	f.write(QString("nbGreenBits2= %1 | nbBlueBits2= %2 | nbAlphaBits2= %3 | redMax= %4 | greenMax= %5\n")
-	            .arg(h.nbGreenBits2).arg(h.nbBlueBits2).arg(h.nbAlphaBits2).arg(h.redMax).arg(h.greenMax).toLatin1());
-	f.write(QString("blueMax= %1 | alphaMax= %2 | hasColorKeyArray= %3 | runtimeData2= %4 | referenceAlpha= %5\n")
-	            .arg(h.blueMax).arg(h.alphaMax).arg(h.hasColorKeyArray).arg(h.runtimeData2).arg(h.referenceAlpha).toLatin1());
-	f.write(QString("runtimeData3= %1 | unknown6= %2 | paletteIndex= %3 | runtimeData4= %4 | runtimeData5= %5\n")
-	            .arg(h.runtimeData3).arg(h.unknown6).arg(h.paletteIndex).arg(h.runtimeData4).arg(h.runtimeData5).toLatin1());
-	f.write(QString("unknown7= %1 | unknown8= %2 | unknown9= %3 | unknown10= %4 | unknown11= %5\n")
-	            .arg(h.unknown7).arg(h.unknown8).arg(h.unknown9).arg(h.unknown10).arg(h.unknown11).toLatin1());
+
+	for (int i = 0; i < TEX_FIELD_COUNT; ++i) {
+		const TexField &field = texFields[i];
+		f.write(QString("%1= %2").arg(field.name).arg(texFieldValue(_header, field)).toLatin1());
+		f.write((i + 1) % 5 == 0 ? "\n" : " | ");
+	}
 
 	for(int i=0 ; i<_colorTables.size() ; ++i) {
 		f.write(QString("Pal %1 ").arg(i).toLatin1());
@@ -100,6 +100,9 @@ public:
 	TexFile(const TextureFile &textureFile, Version version, bool hasAlpha,
 			const QVector<quint8> &colorKeyArray=QVector<quint8>());
 	TexFile(const TextureFile &textureFile);
+	inline TextureFile *clone() const {
+		return new TexFile(*this);
+	}
 	bool open(const QByteArray &data);
 	bool save(QByteArray &data) const;
 	inline quint8 depth() const {
@@ -115,7 +118,18 @@ public:
 		return _header;
 	}
 	void setHeader(Version version, bool hasAlpha, bool fourBitsPerIndex=false);
+	static TexStruct defaultHeader(Version version, bool hasAlpha, bool fourBitsPerIndex,
+	                               quint32 nbPalettes, quint32 width, quint32 height,
+	                               bool hasColorKey=false);
+	static bool headerFromExtraData(const ExtraData &extraData, quint32 nbPalettes,
+	                                quint32 width, quint32 height, bool hasColorKey,
+	                                TexStruct &header);
+	static ExtraData extraDataFromHeader(const TexStruct &header);
+	static bool openHeader(const QByteArray &data, qint64 fileSize, TexStruct &header,
+	                       quint32 *headerSize = 0);
 private:
+	void setPaletteSize(const QSize &size);
+
 	TexStruct _header;
 	QVector<quint8> colorKeyArray;
 };
@@ -0,0 +1,111 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "TextureCache.h"
+#include "TextureFile.h"
+
+// QCache costs are int, they are counted in KiB
+#define TEXTURE_CACHE_COST_UNIT	1024
+
+TextureCache::TextureCache(qint64 maxBytes) :
+	_cache(int(qMin(maxBytes / TEXTURE_CACHE_COST_UNIT, qint64(INT_MAX)))),
+	_hits(0), _misses(0)
+{
+}
+
+QString TextureCache::key(const QString &path, const QString &format)
+{
+	QFileInfo info(path);
+
+	return QString("%1|%2|%3|%4")
+	        .arg(info.absoluteFilePath(), format.toLower())
+	        .arg(info.size())
+	        .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+/*
+ * Returns a copy of the cached texture (pixels are implicitly shared),
+ * or NULL if the file is not in the cache or was modified since.
+ */
+TextureFile *TextureCache::object(const QString &path, const QString &format)
+{
+	const QString k = key(path, format);
+	QMutexLocker locker(&_mutex);
+
+	TextureFile *texture = _cache.object(k);
+	if (!texture) {
+		++_misses;
+		return NULL;
+	}
+
+	++_hits;
+	return texture->clone();
+}
+
+void TextureCache::insert(const QString &path, const QString &format, const TextureFile *texture)
+{
+	const QString k = key(path, format);
+	TextureFile *copy = texture->clone();
+	QMutexLocker locker(&_mutex);
+
+	// Deletes copy if it is bigger than the cache
+	_cache.insert(k, copy, cost(copy));
+}
+
+void TextureCache::clear()
+{
+	QMutexLocker locker(&_mutex);
+	_cache.clear();
+}
+
+qint64 TextureCache::maxBytes() const
+{
+	QMutexLocker locker(&_mutex);
+	return qint64(_cache.maxCost()) * TEXTURE_CACHE_COST_UNIT;
+}
+
+qint64 TextureCache::bytes() const
+{
+	QMutexLocker locker(&_mutex);
+	return qint64(_cache.totalCost()) * TEXTURE_CACHE_COST_UNIT;
+}
+
+quint64 TextureCache::hits() const
+{
+	QMutexLocker locker(&_mutex);
+	return _hits;
+}
+
+quint64 TextureCache::misses() const
+{
+	QMutexLocker locker(&_mutex);
+	return _misses;
+}
+
+int TextureCache::cost(const TextureFile *texture)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	qint64 bytes = texture->image().sizeInBytes();
+#else
+	qint64 bytes = texture->image().byteCount();
+#endif
+
+	foreach (const QVector<QRgb> &colorTable, texture->colorTables()) {
+		bytes += colorTable.size() * qint64(sizeof(QRgb));
+	}
+
+	return int(qMax(qint64(1), (bytes + TEXTURE_CACHE_COST_UNIT - 1) / TEXTURE_CACHE_COST_UNIT));
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <QtCore>
+
+class TextureFile;
+
+/*
+ * Thread-safe LRU cache of opened textures, bounded in bytes.
+ * A file is identified by its path, its size and its modification time.
+ */
+class TextureCache
+{
+public:
+	explicit TextureCache(qint64 maxBytes);
+	TextureFile *object(const QString &path, const QString &format);
+	void insert(const QString &path, const QString &format, const TextureFile *texture);
+	void clear();
+	qint64 maxBytes() const;
+	qint64 bytes() const;
+	quint64 hits() const;
+	quint64 misses() const;
+	static int cost(const TextureFile *texture);
+private:
+	static QString key(const QString &path, const QString &format);
+
+	QCache<QString, TextureFile> _cache;
+	mutable QMutex _mutex;
+	quint64 _hits, _misses;
+};
+
+#endif // TEXTURECACHE_H
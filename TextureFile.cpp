@@ -19,6 +19,10 @@
 #include "TextureImageFile.h"
 #include "TexFile.h"
 #include "TimFile.h"
+#include "TextureRawFile.h"
+#include "ColorIndexer.h"
+#include "Quantizer.h"
+#include "Stats.h"
 
 TextureFile *TextureFile::factory(const QString &format)
 {
@@ -26,6 +30,8 @@ TextureFile *TextureFile::factory(const QString &format)
 		return new TexFile();
 	} else if (format.compare("tim", Qt::CaseInsensitive) == 0) {
 		return new TimFile();
+	} else if (format.compare("raw", Qt::CaseInsensitive) == 0) {
+		return new TextureRawFile();
 	}
 	return new TextureImageFile(format.toUpper().toLocal8Bit().constData());
 }
@@ -60,7 +66,12 @@ bool TextureFile::openFromFile(const QString &filename)
 	if (!f.open(QIODevice::ReadOnly)) {
 		return false;
 	}
-	return open(f.readAll());
+	QByteArray data;
+	{
+		StatsTimer timer(Stats::Read, f.size());
+		data = f.readAll();
+	}
+	return open(data);
 }
 
 bool TextureFile::saveToFile(const QString &filename) const
@@ -73,6 +84,7 @@ bool TextureFile::saveToFile(const QString &filename) const
 	if (!save(data)) {
 		return false;
 	}
+	StatsTimer timer(Stats::Write, data.size());
 	f.write(data);
 	return true;
 }
@@ -151,6 +163,7 @@ int TextureFile::colorTableCount() const
 
 QImage TextureFile::palette() const
 {
+	StatsTimer timer(Stats::ColorConversion);
 	if (depth() >= 16) {
 		return QImage();
 	}
@@ -213,8 +226,13 @@ bool TextureFile::setPalette(const QImage &image)
 	return true;
 }
 
-void TextureFile::convertToIndexedFormat(int colorTableId)
+/*
+ * Returns the number of pixels not found in the color table,
+ * replaced by the nearest color.
+ */
+int TextureFile::convertToIndexedFormat(int colorTableId)
 {
+	StatsTimer timer(Stats::ColorConversion, 0, _image.width() * _image.height());
 	QVector<QRgb> colors = colorTable(colorTableId);
 
 	// Fixing error with alpha
@@ -226,21 +244,222 @@ void TextureFile::convertToIndexedFormat(int colorTableId)
 		}
 	}
 
-	if (_image.format() == QImage::Format_ARGB32) {
-		QRgb *pixels = (QRgb *)_image.bits();
-		for (int i=0; i<_image.height() * _image.width(); ++i) {
-			QRgb color = *pixels;
-			if (qAlpha(color) == 0 && color != qRgba(0, 0, 0, 0)) {
-				*pixels = qRgba(0, 0, 0, 0);
+	if (_image.format() == QImage::Format_Indexed8) {
+		return remapIndexes(colors);
+	}
+
+	const QImage source = _image.format() == QImage::Format_ARGB32
+	        ? _image
+	        : _image.convertToFormat(QImage::Format_ARGB32);
+	QImage image(source.size(), QImage::Format_Indexed8);
+	ColorIndexer indexer(colors);
+	int offPalette = 0;
+	bool exact;
+
+	image.setColorTable(colors);
+
+	for (int y = 0; y < source.height(); ++y) {
+		const QRgb *pixels = (const QRgb *)source.constScanLine(y);
+		uchar *indexes = image.scanLine(y);
+
+		for (int x = 0; x < source.width(); ++x) {
+			QRgb color = pixels[x];
+			if (qAlpha(color) == 0) {
+				color = qRgba(0, 0, 0, 0);
+			}
+			indexes[x] = indexer.index(color, &exact);
+			if (!exact) {
+				++offPalette;
 			}
-			pixels++;
 		}
-	} else if (_image.format() == QImage::Format_Indexed8) {
-		_image.setColorTable(colors);
+	}
+
+	_image = image;
+
+	return offPalette;
+}
+
+/*
+ * Same as convertToIndexedFormat for paletted images:
+ * indexes whose color is the same in both color tables are kept.
+ */
+int TextureFile::remapIndexes(const QVector<QRgb> &colors)
+{
+	QVector<QRgb> imageColors = _image.colorTable();
+	uchar newIndexes[256];
+	bool exact[256], identity = true;
+	ColorIndexer indexer(colors);
+
+	for (int i = 0; i < 256; ++i) {
+		newIndexes[i] = uchar(i);
+		exact[i] = true;
+
+		if (i >= imageColors.size()) {
+			continue;
+		}
+
+		QRgb color = imageColors.at(i);
+		if (qAlpha(color) == 0) {
+			color = qRgba(0, 0, 0, 0);
+		}
+
+		if (i >= colors.size() || colors.at(i) != color) {
+			newIndexes[i] = indexer.index(color, &exact[i]);
+			identity = identity && newIndexes[i] == i && exact[i];
+		}
+	}
+
+	_image.setColorTable(colors);
+
+	if (identity) {
+		return 0;
+	}
+
+	int offPalette = 0;
+
+	for (int y = 0; y < _image.height(); ++y) {
+		uchar *indexes = _image.scanLine(y);
+
+		for (int x = 0; x < _image.width(); ++x) {
+			const uchar index = indexes[x];
+			if (!exact[index]) {
+				++offPalette;
+			}
+			indexes[x] = newIndexes[index];
+		}
+	}
+
+	return offPalette;
+}
+
+void TextureFile::convertToTrueColor()
+{
+	if (!isPaletted()) {
 		return;
 	}
 
-	_image = _image.convertToFormat(QImage::Format_Indexed8, colors);
+	StatsTimer timer(Stats::ColorConversion, 0, _image.width() * _image.height());
+
+	_image = _image.convertToFormat(QImage::Format_ARGB32);
+	importColorTables(QList< QVector<QRgb> >());
+	_currentColorTable = 0;
+}
+
+/*
+ * Generates one color table for a truecolor image.
+ */
+bool TextureFile::quantize(quint8 depth)
+{
+	StatsTimer timer(Stats::ColorConversion, 0, _image.width() * _image.height());
+	int colorCount;
+
+	switch(depth) {
+	case 4:
+		colorCount = 16;
+		break;
+	case 8:
+		colorCount = 256;
+		break;
+	default:
+		return false;
+	}
+
+	if (_image.isNull()) {
+		return false;
+	}
+
+	QImage image = Quantizer::quantize(_image, colorCount);
+
+	importColorTables(QList< QVector<QRgb> >() << image.colorTable());
+	image.setColorTable(_colorTables.first());
+	_image = image;
+	_currentColorTable = 0;
+	setPaletteSize(QSize(colorCount, 1));
+
+	return true;
+}
+
+/*
+ * Removes duplicated color tables, and reduces the depth to 4
+ * when 16 colors are enough (unused colors are removed).
+ * Returns false when nothing changed.
+ */
+bool TextureFile::shrinkPalettes()
+{
+	StatsTimer timer(Stats::ColorConversion, 0, _image.width() * _image.height());
+	if (!isPaletted() || _image.format() != QImage::Format_Indexed8) {
+		return false;
+	}
+
+	bool used[256] = { false };
+	for (int y = 0; y < _image.height(); ++y) {
+		const uchar *indexes = _image.constScanLine(y);
+		for (int x = 0; x < _image.width(); ++x) {
+			used[indexes[x]] = true;
+		}
+	}
+
+	QVector<int> usedIndexes;
+	for (int i = 0; i < 256; ++i) {
+		if (used[i]) {
+			usedIndexes.append(i);
+		}
+	}
+
+	const bool reduceDepth = depth() == 8 && usedIndexes.size() <= 16
+	        && supportsDepth(4);
+	const QList< QVector<QRgb> > oldColorTables = exportColorTables();
+	QList< QVector<QRgb> > colorTables;
+	int currentColorTable = 0;
+
+	for (int j = 0; j < oldColorTables.size(); ++j) {
+		const QVector<QRgb> &colorTable = oldColorTables.at(j);
+		QVector<QRgb> newColorTable = colorTable;
+
+		if (reduceDepth) {
+			newColorTable.fill(qRgba(0, 0, 0, 0), 16);
+			for (int i = 0; i < usedIndexes.size(); ++i) {
+				newColorTable[i] = colorTable.value(usedIndexes.at(i));
+			}
+		}
+
+		int id = colorTables.indexOf(newColorTable);
+		if (id < 0) {
+			id = colorTables.size();
+			colorTables.append(newColorTable);
+		}
+		if (j == _currentColorTable) {
+			currentColorTable = id;
+		}
+	}
+
+	if (!reduceDepth && colorTables.size() == _colorTables.size()) {
+		return false;
+	}
+
+	if (reduceDepth) {
+		uchar newIndexes[256] = { 0 };
+		for (int i = 0; i < usedIndexes.size(); ++i) {
+			newIndexes[usedIndexes.at(i)] = uchar(i);
+		}
+
+		for (int y = 0; y < _image.height(); ++y) {
+			uchar *indexes = _image.scanLine(y);
+			for (int x = 0; x < _image.width(); ++x) {
+				indexes[x] = newIndexes[indexes[x]];
+			}
+		}
+	}
+
+	importColorTables(colorTables);
+	_currentColorTable = currentColorTable;
+	_image.setColorTable(_colorTables.at(_currentColorTable));
+	if (reduceDepth) {
+		setDepth(4);
+	}
+	setPaletteSize(QSize(colorPerPal(), colorTables.size()));
+
+	return true;
 }
 
 quint16 TextureFile::colorPerPal() const
@@ -276,8 +495,10 @@ void TextureFile::setPaletteSize(const QSize &size)
 
 void TextureFile::setDepth(quint8 depth)
 {
-	if (this->depth() != depth) {
-		// TODO
+	if (depth < 16 && !isPaletted()) {
+		quantize(depth);
+	} else if (depth >= 16 && isPaletted()) {
+		convertToTrueColor();
 	}
 }
 
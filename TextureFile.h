@@ -34,6 +34,7 @@ public:
 	static TextureFile *factory(const QString &format);
 	TextureFile();
 	virtual ~TextureFile() {}
+	virtual TextureFile *clone() const=0;
 	bool openFromFile(const QString &filename);
 	virtual bool open(const QByteArray &data)=0;
 	bool saveToFile(const QString &filename) const;
@@ -50,11 +51,18 @@ public:
 	void setCurrentColorTable(int id);
 	void setColorTable(int id, const QVector<QRgb> &colorTable);
 	int colorTableCount() const;
+	// Color tables like in palette files
+	inline QList< QVector<QRgb> > paletteColorTables() const {
+		return exportColorTables();
+	}
 	virtual quint8 depth() const=0;
 	virtual void setDepth(quint8 depth);
 	QImage palette() const;
 	bool setPalette(const QImage &image);
-	void convertToIndexedFormat(int colorTableId);
+	int convertToIndexedFormat(int colorTableId);
+	void convertToTrueColor();
+	bool quantize(quint8 depth);
+	bool shrinkPalettes();
 	quint16 colorPerPal() const;
 	virtual QSize paletteSize() const;
 	void debug() const;
@@ -63,7 +71,12 @@ protected:
 	TextureFile(const QImage &image);
 	TextureFile(const QImage &image, const QList< QVector<QRgb> > &colorTables);
 	quint16 colorPerPalFromDepth() const;
+	int remapIndexes(const QVector<QRgb> &colors);
 	virtual void setPaletteSize(const QSize &size);
+	virtual inline bool supportsDepth(quint8 depth) const {
+		Q_UNUSED(depth);
+		return true;
+	}
 	virtual inline QList< QVector<QRgb> > exportColorTables() const {
 		return _colorTables;
 	}
@@ -16,6 +16,7 @@
  ****************************************************************************/
 #include "TextureImageFile.h"
 #include <QBuffer>
+#include "Stats.h"
 
 TextureImageFile::TextureImageFile(const char *format) :
     _format(format)
@@ -24,21 +25,30 @@ TextureImageFile::TextureImageFile(const char *format) :
 
 bool TextureImageFile::open(const QByteArray &data)
 {
+	StatsTimer timer(Stats::Decode, data.size());
 	bool ret = _image.loadFromData(data, _format);
 	_colorTables.clear();
-	if (_image.format() == QImage::Format_Mono || _image.format() == QImage::Format_Mono || _image.format() == QImage::Format_Mono) {
+	_currentColorTable = 0;
+	if (_image.format() == QImage::Format_Mono || _image.format() == QImage::Format_MonoLSB) {
+		_image = _image.convertToFormat(QImage::Format_Indexed8);
+	}
+	// Paletted images keep their indexes
+	if (_image.format() == QImage::Format_Indexed8 && _image.colorCount() > 0) {
 		_colorTables.append(_image.colorTable());
 	}
+	timer.setPixels(_image.width() * _image.height());
 	return ret;
 }
 
 bool TextureImageFile::save(QByteArray &data) const
 {
+	StatsTimer timer(Stats::ImageEncode, 0, _image.width() * _image.height());
 	QBuffer buff;
 
 	bool ret = _image.save(&buff, _format);
 
 	data = buff.data();
+	timer.setBytes(data.size());
 
 	return ret;
 }
@@ -24,6 +24,9 @@ class TextureImageFile : public TextureFile
 public:
 	TextureImageFile(const char *format);
 	TextureImageFile(const TextureFile &textureFile);
+	inline TextureFile *clone() const {
+		return new TextureImageFile(*this);
+	}
 	bool open(const QByteArray &data);
 	bool save(QByteArray &data) const;
 	inline quint8 depth() const {
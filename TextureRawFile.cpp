@@ -0,0 +1,170 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "TextureRawFile.h"
+#include "Stats.h"
+#include <climits>
+
+TextureRawFile::TextureRawFile() :
+	TextureFile(), _alignment(16), _sourceDepth(32)
+{
+}
+
+TextureRawFile::TextureRawFile(const TextureFile &textureFile) :
+	TextureFile(textureFile), _alignment(16), _sourceDepth(textureFile.depth())
+{
+	if (isPaletted()) {
+		_colorTables = textureFile.paletteColorTables();
+	}
+}
+
+quint8 TextureRawFile::depth() const
+{
+	if (!isPaletted()) {
+		return 32;
+	}
+	return colorPerPal() <= 16 ? 4 : 8;
+}
+
+quint32 TextureRawFile::align(quint32 offset) const
+{
+	return (offset + _alignment - 1) / _alignment * _alignment;
+}
+
+bool TextureRawFile::open(const QByteArray &data)
+{
+	StatsTimer timer(Stats::Decode, data.size());
+	const char *constData = data.constData();
+	TextureRawHeader header;
+
+	if ((quint32)data.size() < sizeof(TextureRawHeader)) {
+		qWarning() << "raw size too short!";
+		return false;
+	}
+
+	memcpy(&header, constData, sizeof(TextureRawHeader));
+
+	if (memcmp(header.magic, "TRAW", 4) != 0 || header.version != 1) {
+		qWarning() << "unknown raw format!";
+		return false;
+	}
+
+	// QImage sizes are ints, and rowSize * height must not overflow
+	if (header.width > quint32(INT_MAX) || header.height > quint32(INT_MAX)) {
+		qWarning() << "raw invalid size!";
+		return false;
+	}
+
+	const bool paletted = header.colorsPerPalette > 0;
+	const quint64 paletteSize = quint64(header.colorsPerPalette) * header.paletteCount * 4,
+	        rowSize = quint64(header.width) * header.bytesPerPixel;
+
+	if (header.bytesPerPixel != (paletted ? 1 : 4)
+	        || header.colorsPerPalette > 256
+	        || (paletted && header.paletteCount == 0)
+	        || sizeof(TextureRawHeader) + quint64(header.nameSize) > (quint64)data.size()
+	        || header.paletteOffset + paletteSize > (quint64)data.size()
+	        || header.pixelOffset + rowSize * header.height > (quint64)data.size()) {
+		qWarning() << "raw invalid size!";
+		return false;
+	}
+
+	_name = QString::fromUtf8(constData + sizeof(TextureRawHeader), header.nameSize);
+	_sourceDepth = header.sourceDepth;
+	_colorTables.clear();
+	_currentColorTable = 0;
+
+	const uchar *palette = (const uchar *)constData + header.paletteOffset;
+	for (quint32 palID = 0; palID < header.paletteCount; ++palID) {
+		QVector<QRgb> colorTable;
+		for (quint32 i = 0; i < header.colorsPerPalette; ++i) {
+			colorTable.append(qRgba(palette[0], palette[1], palette[2], palette[3]));
+			palette += 4;
+		}
+		_colorTables.append(colorTable);
+	}
+
+	QImage image(header.width, header.height, paletted ? QImage::Format_Indexed8 : QImage::Format_RGBA8888);
+	const char *pixels = constData + header.pixelOffset;
+
+	if (image.isNull()) {
+		qWarning() << "raw image too big!" << header.width << header.height;
+		return false;
+	}
+
+	for (quint32 y = 0; y < header.height; ++y) {
+		memcpy(image.scanLine(y), pixels + y * rowSize, rowSize);
+	}
+
+	if (paletted) {
+		image.setColorTable(_colorTables.first());
+		_image = image;
+	} else {
+		_image = image.convertToFormat(QImage::Format_ARGB32);
+	}
+
+	timer.setPixels(_image.width() * _image.height());
+	return true;
+}
+
+bool TextureRawFile::save(QByteArray &data) const
+{
+	const QByteArray name = _name.toUtf8();
+	const bool paletted = isPaletted() && _image.format() == QImage::Format_Indexed8;
+	TextureRawHeader header;
+	StatsTimer timer(Stats::Encode, 0, _image.width() * _image.height());
+
+	memcpy(header.magic, "TRAW", 4);
+	header.version = 1;
+	header.bytesPerPixel = paletted ? 1 : 4;
+	header.width = _image.width();
+	header.height = _image.height();
+	header.sourceDepth = _sourceDepth;
+	header.colorsPerPalette = paletted ? colorPerPal() : 0;
+	header.paletteCount = paletted ? colorTableCount() : 0;
+	header.nameSize = name.size();
+	header.paletteOffset = align(sizeof(TextureRawHeader) + header.nameSize);
+	header.pixelOffset = align(header.paletteOffset + header.colorsPerPalette * header.paletteCount * 4);
+	header.recordSize = align(header.pixelOffset + header.width * header.height * header.bytesPerPixel);
+
+	const int start = data.size();
+	data.append(QByteArray(header.recordSize, '\0'));
+	char *out = data.data() + start;
+
+	memcpy(out, &header, sizeof(TextureRawHeader));
+	memcpy(out + sizeof(TextureRawHeader), name.constData(), header.nameSize);
+
+	uchar *palette = (uchar *)out + header.paletteOffset;
+	foreach (const QVector<QRgb> &colorTable, paletted ? _colorTables : QList< QVector<QRgb> >()) {
+		for (quint32 i = 0; i < header.colorsPerPalette; ++i) {
+			const QRgb color = colorTable.value(i);
+			*palette++ = qRed(color);
+			*palette++ = qGreen(color);
+			*palette++ = qBlue(color);
+			*palette++ = qAlpha(color);
+		}
+	}
+
+	const QImage image = paletted ? _image : _image.convertToFormat(QImage::Format_RGBA8888);
+	const quint32 rowSize = header.width * header.bytesPerPixel;
+
+	for (quint32 y = 0; y < header.height; ++y) {
+		memcpy(out + header.pixelOffset + y * rowSize, image.constScanLine(y), rowSize);
+	}
+
+	timer.setBytes(header.recordSize);
+	return true;
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef TEXTURERAWFILE_H
+#define TEXTURERAWFILE_H
+
+#include "TextureFile.h"
+
+/*
+ * Little endian, offsets from the start of the record.
+ * The sections are aligned, the record size too
+ * (records can be concatenated).
+ */
+typedef struct {
+	char magic[4]; // "TRAW"
+	quint16 version; // 1
+	quint16 bytesPerPixel; // 1 (indexes) or 4 (RGBA)
+	quint32 width;
+	quint32 height;
+	quint32 sourceDepth; // Depth of the original texture
+	quint32 colorsPerPalette; // 0 if not paletted
+	quint32 paletteCount;
+	quint32 nameSize; // UTF-8 name after the header
+	quint32 paletteOffset; // RGBA colors
+	quint32 pixelOffset;
+	quint32 recordSize;
+} TextureRawHeader;
+
+/*
+ * Uncompressed pixels: RGBA, or indexes with all the palettes
+ * (semi-transparent colors have alpha 127, like in palette files).
+ */
+class TextureRawFile : public TextureFile
+{
+public:
+	TextureRawFile();
+	explicit TextureRawFile(const TextureFile &textureFile);
+	inline TextureFile *clone() const {
+		return new TextureRawFile(*this);
+	}
+	bool open(const QByteArray &data);
+	bool save(QByteArray &data) const;
+	quint8 depth() const;
+	inline void setAlignment(quint32 alignment) {
+		_alignment = qMax(alignment, 1u);
+	}
+	inline void setName(const QString &name) {
+		_name = name;
+	}
+	inline const QString &name() const {
+		return _name;
+	}
+private:
+	quint32 align(quint32 offset) const;
+
+	quint32 _alignment, _sourceDepth;
+	QString _name;
+};
+
+#endif // TEXTURERAWFILE_H
@@ -17,6 +17,7 @@
  ****************************************************************************/
 #include "TimFile.h"
 #include "PsColor.h"
+#include "Stats.h"
 
 TimFile::TimFile() :
 	TextureFile(), bpp(1), palX(0), palY(0), palW(0), palH(0), imgX(0), imgY(0)
@@ -26,13 +27,93 @@ TimFile::TimFile() :
 TimFile::TimFile(const TextureFile &texture, quint16 palX, quint16 palY, quint16 imgX, quint16 imgY) :
 	TextureFile(texture), palX(palX), palY(palY), imgX(imgX), imgY(imgY)
 {
-	setDepth(texture.depth());
+	setBpp(texture.depth());
 	setPaletteSize(texture.paletteSize());
 }
 
+/*
+ * The first 8 bytes: version and flags.
+ */
+bool TimFile::openFlags(const char *data, bool &hasPal)
+{
+//	quint8 tag = (quint8)data[0];
+#ifdef TIMFILE_EXTRACT_UNUSED_DATA
+	_version = (quint8)data[1];
+	memcpy(&_headerUnused1, data + 2, 2);
+	memcpy(&_headerUnused2, data + 4, 4);
+	_headerUnused2 &= 0xFFF8;
+#endif
+	bpp = (quint8)data[4] & 3;
+	hasPal = ((quint8)data[4] >> 3) & 1;
+
+	if(hasPal && bpp > 1) {
+		qWarning() << "Bits Per Pixel is 16 and there are palettes";
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Reads the palette and image headers only, with the header checks
+ * of open(). The image stays empty, but extraData() is set.
+ */
+bool TimFile::openHeader(QIODevice *device)
+{
+	const qint64 dataSize = device->size();
+	quint32 palSize = 0;
+	char data[20];
+	bool hasPal;
+
+	if(!device->seek(0) || device->read(data, 8) != 8
+	        || memcmp(data, "\x10\x00\x00\x00", 4) != 0) {
+		qWarning() << "Invalid TIM header";
+		return false;
+	}
+
+	if(!openFlags(data, hasPal)) {
+		return false;
+	}
+
+	if(hasPal) {
+		if(dataSize < 20 || device->read(data + 8, 12) != 12) {
+			qWarning() << "File too short to have palettes";
+			return false;
+		}
+
+		memcpy(&palSize, data + 8, 4);
+		memcpy(&palX, data + 12, 2);
+		memcpy(&palY, data + 14, 2);
+		memcpy(&palW, data + 16, 2);
+		memcpy(&palH, data + 18, 2);
+
+		if(dataSize < 8 + qint64(palSize)) {
+			qWarning() << "File too short for the size of palettes section" << palSize;
+			return false;
+		}
+
+		const quint32 onePalSize = bpp == 0 ? 16 : 256;
+		if(palSize < 12 + onePalSize * 2) {
+			qWarning() << "TimFile::openHeader no palette" << palSize;
+			return false;
+		}
+	}
+
+	if(dataSize < 20 + qint64(palSize) || !device->seek(8 + palSize)
+	        || device->read(data + 8, 12) != 12) {
+		qWarning() << "File too short";
+		return false;
+	}
+
+	memcpy(&imgX, data + 12, 2);
+	memcpy(&imgY, data + 14, 2);
+
+	return true;
+}
+
 bool TimFile::open(const QByteArray &data)
 {
-	//	QTime t;t.start();
+	StatsTimer timer(Stats::Decode, data.size());
 
 	quint32 palSize=0, imgSize=0, color=0;
 	quint16 w, h;
@@ -45,27 +126,21 @@ bool TimFile::open(const QByteArray &data)
 		return false;
 	}
 
-//	quint8 tag = (quint8)data.at(0);
-#ifdef TIMFILE_EXTRACT_UNUSED_DATA
-	_version = (quint8)data.at(1);
-	memcpy(&_headerUnused1, constData + 2, 2);
-	memcpy(&_headerUnused2, constData + 4, 4);
-	_headerUnused2 &= 0xFFF8;
-#endif
-	bpp = (quint8)data.at(4) & 3;
-	hasPal = ((quint8)data.at(4) >> 3) & 1;
-
 //	qDebug() << QString("=== Apercu TIM ===");
 //	qDebug() << QString("version = %1, reste = %2").arg(version).arg(QString(data.mid(2,2).toHex()));
 //	qDebug() << QString("bpp = %1, hasPal = %2, flag = %3, reste = %4").arg(bpp).arg(hasPal).arg((quint8)data.at(4),0,2).arg(QString(data.mid(5,3).toHex()));
 	
-	if(hasPal && bpp > 1) {
-		qWarning() << "Bits Per Pixel is 16 and there are palettes";
+	if(!openFlags(constData, hasPal)) {
 		return false;
 	}
 
 	_colorTables.clear();
 	_alphaBits.clear();
+	_rawColorTables.clear();
+	_openedColorTables.clear();
+	_openedAlphaBits.clear();
+	_openedImage = QImage();
+	_rawPixels.clear();
 
 	if(hasPal)
 	{
@@ -100,16 +175,20 @@ bool TimFile::open(const QByteArray &data)
 			int pos=0;
 			for(int i=0 ; i<nbPal ; ++i) {
 				QVector<QRgb> pal;
+				QVector<quint16> rawPal(onePalSize);
 				QBitArray alphaBits(onePalSize);
 
+				memcpy(rawPal.data(), constData + 20 + pos*2, onePalSize*2);
+
 				for(quint16 j=0 ; j<onePalSize ; ++j) {
-					memcpy(&color, constData + 20 + pos*2 + j*2, 2);
+					color = rawPal.at(j);
 					pal.append(PsColor::fromPsColor(color, true));
 					alphaBits.setBit(j, psColorAlphaBit(color));
 				}
 
 				_colorTables.append(pal);
 				_alphaBits.append(alphaBits);
+				_rawColorTables.append(rawPal);
 
 				pos += pos % palW == 0 ? onePalSize : palW - onePalSize;
 			}
@@ -217,6 +296,8 @@ bool TimFile::open(const QByteArray &data)
 		}
 
 		_alphaBits.append(alphaBits);
+		_openedImage = _image;
+		_rawPixels = data.mid(20 + palSize, w*2*h);
 	}
 	else if(bpp==3)
 	{
@@ -235,7 +316,10 @@ bool TimFile::open(const QByteArray &data)
 		}
 	}
 
-//	qDebug() << t.elapsed();
+	_openedColorTables = _colorTables;
+	_openedAlphaBits = _alphaBits;
+
+	timer.setPixels(w * h);
 	return true;
 }
 
@@ -243,6 +327,8 @@ bool TimFile::save(QByteArray &data) const
 {
 	Q_ASSERT(_colorTables.size() == _alphaBits.size());
 
+	StatsTimer timer(Stats::Encode, 0, _image.width() * _image.height());
+	const int start = data.size();
 	bool hasPal = isPaletted();
 	quint32 flag = (hasPal << 3) | (bpp & 3);
 
@@ -263,15 +349,29 @@ bool TimFile::save(QByteArray &data) const
 		int colorTableId = 0;
 		foreach(const QVector<QRgb> &colorTable, _colorTables) {
 			const QBitArray &alphaBit = _alphaBits.at(colorTableId);
+			const bool hasRaw = colorTableId < _rawColorTables.size()
+			        && _rawColorTables.at(colorTableId).size() == colorPerPal;
 			int i;
 
 			Q_ASSERT(colorTable.size() == colorPerPal);
 			Q_ASSERT(alphaBit.size() == colorPerPal);
 
-			for(i=0 ; i<colorPerPal ; ++i) {
-				quint16 psColor = PsColor::toPsColor(colorTable.at(i));
-				psColor = setPsColorAlphaBit(psColor, alphaBit.at(i));
-				data.append((char *)&psColor, 2);
+			if(hasRaw && colorTable == _openedColorTables.at(colorTableId)
+			        && alphaBit == _openedAlphaBits.at(colorTableId)) {
+				// Unmodified
+				data.append((const char *)_rawColorTables.at(colorTableId).constData(), colorPerPal * 2);
+			} else {
+				for(i=0 ; i<colorPerPal ; ++i) {
+					quint16 psColor;
+					if(hasRaw && colorTable.at(i) == _openedColorTables.at(colorTableId).at(i)
+					        && alphaBit.at(i) == _openedAlphaBits.at(colorTableId).at(i)) {
+						psColor = _rawColorTables.at(colorTableId).at(i);
+					} else {
+						psColor = PsColor::toPsColor(colorTable.at(i));
+						psColor = setPsColorAlphaBit(psColor, alphaBit.at(i));
+					}
+					data.append((char *)&psColor, 2);
+				}
 			}
 
 			++colorTableId;
@@ -297,19 +397,23 @@ bool TimFile::save(QByteArray &data) const
 		width *= 2;
 
 		for(int y=0 ; y<height ; ++y) {
-			for(int x=0 ; x<width ; ++x) {
-				if(bpp == 0) {
-					quint8 index = (_image.pixelIndex(x*2, y) & 0xF) | ((_image.pixelIndex(x*2+1, y) & 0xF) << 4);
+			const uchar *indexes = _image.constScanLine(y);
+			if(bpp == 0) {
+				for(int x=0 ; x<width ; ++x) {
+					quint8 index = (indexes[x*2] & 0xF) | ((indexes[x*2+1] & 0xF) << 4);
 					data.append((char)index);
-				} else {
-					data.append((char)_image.pixelIndex(x, y));
 				}
+			} else {
+				data.append((const char *)indexes, width);
 			}
 		}
 	} else {
 		quint16 width = _image.width(), height = _image.height();
 		quint32 sizeImgSection = 12 + width * bpp * height;
-		const QBitArray &alphaBit = _alphaBits.first();
+		// No STP bits for images that were not opened from a TIM file
+		const QBitArray alphaBit = _alphaBits.isEmpty()
+		        ? QBitArray(width * height)
+		        : _alphaBits.first();
 
 		data.append((char *)&sizeImgSection, 4);
 		data.append((char *)&imgX, 2);
@@ -317,11 +421,39 @@ bool TimFile::save(QByteArray &data) const
 		data.append((char *)&width, 2);
 		data.append((char *)&height, 2);
 
+		// Unmodified rows are saved as is
+		const bool hasRaw = bpp == 2 && _openedImage.size() == _image.size()
+		        && _openedImage.format() == _image.format()
+		        && _openedAlphaBits.size() == 1;
+		const bool alphaBitUnmodified = hasRaw && alphaBit == _openedAlphaBits.first();
+
+		if(hasRaw && alphaBitUnmodified && _image == _openedImage
+		        && _rawPixels.size() == width * 2 * height) {
+			data.append(_rawPixels);
+			timer.setBytes(data.size() - start);
+			return true;
+		}
+
 		for(int y=0 ; y<height ; ++y) {
+			if(hasRaw && _rawPixels.size() >= (y + 1) * width * 2
+			        && memcmp(_image.constScanLine(y), _openedImage.constScanLine(y), width * 4) == 0) {
+				bool rowUnmodified = true;
+				for(int x=0 ; !alphaBitUnmodified && x<width ; ++x) {
+					if(alphaBit.at(y * width + x) != _openedAlphaBits.first().at(y * width + x)) {
+						rowUnmodified = false;
+						break;
+					}
+				}
+				if(rowUnmodified) {
+					data.append(_rawPixels.constData() + y * width * 2, width * 2);
+					continue;
+				}
+			}
+
 			for(int x=0 ; x<width ; ++x) {
 				if(bpp == 2) {
 					quint16 color = PsColor::toPsColor(_image.pixel(x, y));
-					setPsColorAlphaBit(color, alphaBit.at(y * width + x));
+					color = setPsColorAlphaBit(color, alphaBit.at(y * width + x));
 					data.append((char *)&color, 2);
 				} else {
 					QRgb c = _image.pixel(x, y);
@@ -332,10 +464,24 @@ bool TimFile::save(QByteArray &data) const
 		}
 	}
 
+	timer.setBytes(data.size() - start);
 	return true;
 }
 
+/*
+ * Converts the image like TexFile::setDepth: quantized when not paletted,
+ * or converted to true color.
+ */
 void TimFile::setDepth(quint8 depth)
+{
+	TextureFile::setDepth(depth);
+	setBpp(depth);
+}
+
+/*
+ * Header only, the image is not converted.
+ */
+void TimFile::setBpp(quint8 depth)
 {
 	if (depth < 8) {
 		bpp = 0;
@@ -372,7 +518,8 @@ bool TimFile::setExtraData(const ExtraData &extraData)
 
 	setExtraDataField(depth, "depth");
 	if (depth != 255) {
-		setDepth(depth);
+		// Converted later, with the palette file if any
+		setBpp(depth);
 	}
 	setExtraDataField(palX, "paletteX");
 	setExtraDataField(palY, "paletteY");
@@ -398,6 +545,19 @@ void TimFile::setPaletteSize(const QSize &size)
 	palH = size.height();
 }
 
+bool TimFile::supportsDepth(quint8 depth) const
+{
+	// The width is stored in 16-bit words
+	switch(depth) {
+	case 4:
+		return _image.width() % 4 == 0;
+	case 8:
+		return _image.width() % 2 == 0;
+	default:
+		return true;
+	}
+}
+
 QList< QVector<QRgb> > TimFile::exportColorTables() const
 {
 	QList< QVector<QRgb> > ret;
@@ -512,6 +672,7 @@ QList<PosSize> TimFile::findTims(QIODevice *device, int limit)
 
 	while (nextTim(device, limit)) {
 		index = device->pos();
+		palSize = 0; // No palette section for 16 and 24-bit
 
 		if (!device->seek(device->pos() + 4)) {
 			break;
@@ -33,7 +33,11 @@ public:
 	TimFile(const TextureFile &texture,
 	        quint16 palX=0, quint16 palY=0,
 	        quint16 imgX=0, quint16 imgY=0);
+	inline TextureFile *clone() const {
+		return new TimFile(*this);
+	}
 	bool open(const QByteArray &data);
+	bool openHeader(QIODevice *device);
 	bool save(QByteArray &data) const;
 	inline quint8 depth() const {
 		if (bpp == 0) {
@@ -70,7 +74,10 @@ public:
 	static QList<PosSize> findTims(QIODevice *device, int limit = 0);
 private:
 	static bool nextTim(QIODevice *device, qint64 limit = 0);
+	bool openFlags(const char *data, bool &hasPal);
 	void setPaletteSize(const QSize &size);
+	void setBpp(quint8 depth);
+	bool supportsDepth(quint8 depth) const;
 	QList< QVector<QRgb> > exportColorTables() const;
 	void importColorTables(const QList< QVector<QRgb> > &colorTables);
 
@@ -79,6 +86,12 @@ private:
 	quint16 palW, palH;
 	quint16 imgX, imgY;
 	QList<QBitArray> _alphaBits;
+	// Data of the opened file, unmodified colors are saved as is
+	QList< QVector<quint16> > _rawColorTables;
+	QList< QVector<QRgb> > _openedColorTables;
+	QList<QBitArray> _openedAlphaBits;
+	QImage _openedImage;
+	QByteArray _rawPixels;
 #ifdef TIMFILE_EXTRACT_UNUSED_DATA
 	quint8 _version;
 	quint16 _headerUnused1;
@@ -0,0 +1,188 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Trace.h"
+
+bool Trace::_enabled = false;
+QElapsedTimer Trace::_clock;
+QList<Trace::Buffer *> Trace::_buffers;
+QList<Trace::Buffer *> Trace::_freeBuffers;
+QMutex Trace::_buffersMutex;
+
+void Trace::setEnabled(bool enabled)
+{
+	_enabled = enabled;
+	if (enabled) {
+		_clock.start();
+	}
+}
+
+/*
+ * Gives back the buffer when its thread exits.
+ */
+Trace::BufferHolder::~BufferHolder()
+{
+	if (buffer) {
+		QMutexLocker locker(&_buffersMutex);
+		_freeBuffers.append(buffer);
+	}
+}
+
+/*
+ * The buffer of the current thread, set on its first event.
+ * Buffers are never freed, so the events of finished threads are kept,
+ * but the buffer of a finished thread is reused by the next new thread
+ * (thread pools recreate their expired threads): the memory depends on
+ * the number of threads running at once, and both threads share a row
+ * in the timeline.
+ */
+Trace::Buffer *Trace::threadBuffer()
+{
+	static thread_local BufferHolder holder;
+	Buffer *&buffer = holder.buffer;
+
+	if (!buffer) {
+		QMutexLocker locker(&_buffersMutex);
+
+		if (!_freeBuffers.isEmpty()) {
+			buffer = _freeBuffers.takeLast();
+			return buffer;
+		}
+
+		const int threadId = _buffers.size() + 1;
+		QString threadName = QThread::currentThread()->objectName();
+
+		if (QCoreApplication::instance()
+		        && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+			threadName = "main";
+		} else if (threadName.isEmpty()) {
+			threadName = QString("thread %1").arg(threadId);
+		}
+
+		buffer = new Buffer(threadId, threadName);
+		_buffers.append(buffer);
+	}
+
+	return buffer;
+}
+
+void Trace::add(const char *name, qint64 begin, qint64 end, const QString &detail)
+{
+	Buffer *buffer = threadBuffer();
+	Event &event = buffer->events[buffer->next];
+
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	event.detail = detail;
+
+	// The oldest events are overwritten
+	if (++buffer->next == TRACE_BUFFER_SIZE) {
+		buffer->next = 0;
+		buffer->wrapped = true;
+	}
+}
+
+QByteArray Trace::escape(const QString &text)
+{
+	QByteArray ret;
+
+	foreach (const char c, text.toUtf8()) {
+		switch (c) {
+		case '"':  ret.append("\\\"");
+			break;
+		case '\\': ret.append("\\\\");
+			break;
+		case '\n': ret.append("\\n");
+			break;
+		default:
+			if (uchar(c) < 0x20) {
+				ret.append(QString("\\u%1").arg(int(c), 4, 16, QChar('0')).toLatin1());
+			} else {
+				ret.append(c);
+			}
+			break;
+		}
+	}
+
+	return ret;
+}
+
+bool Trace::save(const QString &path)
+{
+	QFile f(path);
+
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(path) << f.errorString();
+		return false;
+	}
+
+	QMutexLocker locker(&_buffersMutex);
+	QByteArray data("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+
+	foreach (const Buffer *buffer, _buffers) {
+		if (!first) {
+			data.append(",\n");
+		}
+		first = false;
+
+		data.append(QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"")
+		            .arg(buffer->threadId).toLatin1());
+		data.append(escape(buffer->threadName));
+		data.append("\"}}");
+
+		const int count = buffer->wrapped ? TRACE_BUFFER_SIZE : buffer->next,
+		        start = buffer->wrapped ? buffer->next : 0;
+
+		for (int i = 0; i < count; ++i) {
+			const Event &event = buffer->events.at((start + i) % TRACE_BUFFER_SIZE);
+
+			// Complete events, times in microseconds
+			data.append(QString(",\n{\"name\":\"%1\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"dur\":%4")
+			            .arg(event.name).arg(buffer->threadId)
+			            .arg(event.begin / 1000.0, 0, 'f', 3)
+			            .arg((event.end - event.begin) / 1000.0, 0, 'f', 3)
+			            .toLatin1());
+			if (!event.detail.isEmpty()) {
+				data.append(",\"args\":{\"detail\":\"");
+				data.append(escape(event.detail));
+				data.append("\"}");
+			}
+			data.append('}');
+		}
+
+		if (buffer->wrapped) {
+			qWarning() << "Warning: trace buffer full, the oldest events of" << buffer->threadName << "are lost";
+		}
+
+		// Flushed by thread, the trace can be big
+		if (f.write(data) != data.size()) {
+			qWarning() << "Error: Cannot save" << QDir::toNativeSeparators(path) << f.errorString();
+			return false;
+		}
+		data.clear();
+	}
+
+	data.append("\n]}\n");
+
+	if (f.write(data) != data.size()) {
+		qWarning() << "Error: Cannot save" << QDir::toNativeSeparators(path) << f.errorString();
+		return false;
+	}
+
+	return true;
+}
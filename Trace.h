@@ -0,0 +1,98 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtCore>
+
+#define TRACE_BUFFER_SIZE	65536 // Events kept per thread
+
+/*
+ * Records spans (name, begin, end, detail) in one ring buffer per thread,
+ * saved in the Chrome trace event format (about:tracing, Perfetto).
+ * Disabled by default: a TraceSpan then only costs a boolean test.
+ */
+class Trace
+{
+public:
+	// Must be called before starting the worker threads
+	static void setEnabled(bool enabled);
+	static inline bool isEnabled() {
+		return _enabled;
+	}
+	static inline qint64 now() {
+		return _clock.nsecsElapsed();
+	}
+	static void add(const char *name, qint64 begin, qint64 end, const QString &detail);
+	// Must be called once the worker threads are done
+	static bool save(const QString &path);
+private:
+	struct Event {
+		const char *name;
+		qint64 begin, end;
+		QString detail;
+	};
+	struct Buffer {
+		Buffer(int threadId, const QString &threadName) :
+			events(TRACE_BUFFER_SIZE), next(0), wrapped(false),
+			threadId(threadId), threadName(threadName) {}
+		QVector<Event> events;
+		int next;
+		bool wrapped;
+		int threadId;
+		QString threadName;
+	};
+	struct BufferHolder {
+		BufferHolder() : buffer(0) {}
+		~BufferHolder();
+		Buffer *buffer;
+	};
+	static Buffer *threadBuffer();
+	static QByteArray escape(const QString &text);
+
+	static bool _enabled;
+	static QElapsedTimer _clock;
+	static QList<Buffer *> _buffers, _freeBuffers;
+	static QMutex _buffersMutex;
+};
+
+/*
+ * Records the time between its construction and its destruction.
+ */
+class TraceSpan
+{
+public:
+	inline explicit TraceSpan(const char *name, const QString &detail = QString()) :
+		_name(name), _begin(Trace::isEnabled() ? Trace::now() : -1)
+	{
+		if (_begin >= 0) {
+			_detail = detail;
+		}
+	}
+	inline ~TraceSpan() {
+		if (_begin >= 0) {
+			Trace::add(_name, _begin, Trace::now(), _detail);
+		}
+	}
+private:
+	Q_DISABLE_COPY(TraceSpan)
+	const char *_name;
+	qint64 _begin;
+	QString _detail;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,278 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Transcoder.h"
+#include "TexFile.h"
+#include "TimFile.h"
+#include "PsColor.h"
+
+bool Transcoder::timToTex(const QByteArray &tim, const ExtraData &meta, QByteArray &tex)
+{
+	const char *constData = tim.constData();
+	const quint32 dataSize = tim.size();
+	quint32 flag, palSize = 0;
+	quint16 palW = 0, w, h, onePalSize = 0;
+	int nbPal = 0;
+
+	if (!tim.startsWith(QByteArray("\x10\x00\x00\x00", 4)) || dataSize < 8) {
+		return false;
+	}
+
+	memcpy(&flag, constData + 4, 4);
+	const quint8 bpp = flag & 3;
+	const bool hasPal = (flag >> 3) & 1;
+
+	// No 24-bit, and no 4/8-bit without palette
+	if (bpp > 2 || hasPal != (bpp < 2)) {
+		return false;
+	}
+
+	if (hasPal) {
+		if (dataSize < 20) {
+			return false;
+		}
+
+		memcpy(&palSize, constData + 8, 4);
+		memcpy(&palW, constData + 16, 2);
+
+		if (palSize < 12 || palW == 0 || dataSize < 8 + palSize) {
+			return false;
+		}
+
+		onePalSize = bpp == 0 ? 16 : 256;
+		nbPal = (palSize - 12) / (onePalSize * 2);
+
+		if (nbPal <= 0) {
+			return false;
+		}
+	}
+
+	if (dataSize < 20 + palSize) {
+		return false;
+	}
+
+	memcpy(&w, constData + 16 + palSize, 2);
+	memcpy(&h, constData + 18 + palSize, 2);
+
+	const quint32 width = bpp == 0 ? w * 4 : (bpp == 1 ? w * 2 : w),
+	        imageStart = 20 + palSize,
+	        imageSectionSize = quint32(w) * 2 * h;
+
+	if (dataSize < imageStart + imageSectionSize) {
+		return false;
+	}
+
+	TexStruct header;
+	if (!TexFile::headerFromExtraData(meta, nbPal, width, h, false, header)) {
+		return false;
+	}
+
+	// The meta data must describe the same palettes
+	if (header.nbPalettes != quint32(nbPal)
+	        || header.bytesPerPixel != (hasPal ? 1u : 2u)
+	        || header.hasColorKeyArray
+	        || (hasPal && (header.nbColorsPerPalette1 != onePalSize
+	                       || header.paletteSize != quint32(nbPal * onePalSize)))) {
+		return false;
+	}
+
+	const int headerSize = header.version >= 2 ? sizeof(TexStruct) : sizeof(TexStruct) - 4;
+	tex.resize(headerSize + nbPal * onePalSize * 4 + width * h * header.bytesPerPixel);
+	uchar *out = (uchar *)tex.data();
+
+	memcpy(out, &header, headerSize);
+	out += headerSize;
+
+	if (hasPal) {
+		quint8 to8Bits[32];
+		int pos = 0;
+
+		for (int i = 0; i < 32; ++i) {
+			to8Bits[i] = quint8(qRound(i * COEFF_COLOR));
+		}
+
+		// Same palette order than TimFile::open
+		for (int i = 0; i < nbPal; ++i) {
+			if (20 + (pos + onePalSize) * 2 > 8 + palSize) {
+				return false;
+			}
+
+			for (quint16 j = 0; j < onePalSize; ++j) {
+				quint16 color;
+				memcpy(&color, constData + 20 + (pos + j) * 2, 2);
+
+				*out++ = to8Bits[(color >> 10) & 31];
+				*out++ = to8Bits[(color >> 5) & 31];
+				*out++ = to8Bits[color & 31];
+				*out++ = color == 0 ? 0 : (psColorAlphaBit(color) ? 127 : 255);
+			}
+
+			pos += pos % palW == 0 ? onePalSize : palW - onePalSize;
+		}
+	}
+
+	const uchar *in = (const uchar *)constData + imageStart;
+
+	if (bpp == 0) {
+		for (quint32 i = 0; i < imageSectionSize; ++i) {
+			*out++ = in[i] & 0xF;
+			*out++ = in[i] >> 4;
+		}
+	} else {
+		// 8-bit indexes and 16-bit colors are the same in TEX files
+		memcpy(out, in, imageSectionSize);
+	}
+
+	return true;
+}
+
+bool Transcoder::texToTim(const QByteArray &tex, const ExtraData &meta, QByteArray &tim)
+{
+	const char *constData = tex.constData();
+	TexStruct header;
+	quint32 headerSize;
+
+	if ((quint32)tex.size() < sizeof(TexStruct)) {
+		return false;
+	}
+
+	memcpy(&header, constData, sizeof(TexStruct));
+
+	if (header.version == 1) {
+		headerSize = sizeof(TexStruct) - 4;
+	} else if (header.version == 2) {
+		headerSize = sizeof(TexStruct);
+	} else {
+		return false;
+	}
+
+	const quint32 width = header.imageWidth, height = header.imageHeight,
+	        nbPal = header.nbPalettes,
+	        colorsPerPal = header.nbColorsPerPalette1,
+	        paletteSectionSize = nbPal > 0 ? header.paletteSize * 4 : 0,
+	        imageSectionSize = width * height * header.bytesPerPixel,
+	        colorKeySectionSize = header.hasColorKeyArray ? nbPal : 0;
+
+	if ((quint32)tex.size() != headerSize + paletteSectionSize + imageSectionSize + colorKeySectionSize
+	        || width > 0xFFFF || height > 0xFFFF) {
+		return false;
+	}
+
+	const uchar *in = (const uchar *)constData + headerSize + paletteSectionSize;
+	quint8 bpp;
+
+	if (nbPal > 0) {
+		if (header.bytesPerPixel != 1 || (colorsPerPal != 16 && colorsPerPal != 256)
+		        || nbPal * colorsPerPal * 4 > paletteSectionSize) {
+			return false;
+		}
+
+		bpp = colorsPerPal == 16 ? 0 : 1;
+
+		// The width is stored in 16-bit words
+		if (width % (bpp == 0 ? 4 : 2) != 0) {
+			return false;
+		}
+
+		if (bpp == 0) {
+			for (quint32 i = 0; i < imageSectionSize; ++i) {
+				if (in[i] >= 16) {
+					return false;
+				}
+			}
+		}
+	} else if (header.bytesPerPixel == 2) {
+		bpp = 2;
+	} else {
+		return false;
+	}
+
+	// Positions in VRAM
+	TimFile timMeta;
+	timMeta.setExtraData(meta);
+
+	if (meta.fields().contains("depth")
+	        && timMeta.depth() != (bpp == 0 ? 4 : bpp * 8)) {
+		return false;
+	}
+
+	const quint32 flag = (quint32(nbPal > 0) << 3) | bpp,
+	        sizePalSection = 12 + nbPal * colorsPerPal * 2;
+	const quint16 palX = timMeta.paletteX(), palY = timMeta.paletteY(),
+	        imgX = timMeta.imageX(), imgY = timMeta.imageY(),
+	        // Same palette size than TextureFile::paletteSize()
+	        palW = 16, palH = quint16(colorsPerPal / 16 * nbPal),
+	        w = quint16(bpp == 0 ? width / 4 : (bpp == 1 ? width / 2 : width)),
+	        h = quint16(height);
+	const quint32 sizeImgSection = 12 + quint32(w) * 2 * h;
+
+	tim.resize(8 + (nbPal > 0 ? sizePalSection : 0) + sizeImgSection);
+	uchar *out = (uchar *)tim.data();
+
+	memcpy(out, "\x10\x00\x00\x00", 4);
+	memcpy(out + 4, &flag, 4);
+	out += 8;
+
+	if (nbPal > 0) {
+		const uchar *palette = (const uchar *)constData + headerSize;
+		quint8 to5Bits[256];
+
+		for (int i = 0; i < 256; ++i) {
+			to5Bits[i] = quint8(qRound(i / COEFF_COLOR) & 31);
+		}
+
+		memcpy(out, &sizePalSection, 4);
+		memcpy(out + 4, &palX, 2);
+		memcpy(out + 6, &palY, 2);
+		memcpy(out + 8, &palW, 2);
+		memcpy(out + 10, &palH, 2);
+		out += 12;
+
+		// Same rules than TimFile::importColorTables
+		for (quint32 i = 0; i < nbPal * colorsPerPal; ++i) {
+			const quint8 alpha = palette[3];
+			quint16 color = 0;
+
+			if (alpha != 0) {
+				color = to5Bits[palette[2]] | (to5Bits[palette[1]] << 5) | (to5Bits[palette[0]] << 10);
+				if (alpha == 127) {
+					color = setPsColorAlphaBit(color, 1);
+				}
+			}
+
+			memcpy(out, &color, 2);
+			out += 2;
+			palette += 4;
+		}
+	}
+
+	memcpy(out, &sizeImgSection, 4);
+	memcpy(out + 4, &imgX, 2);
+	memcpy(out + 6, &imgY, 2);
+	memcpy(out + 8, &w, 2);
+	memcpy(out + 10, &h, 2);
+	out += 12;
+
+	if (bpp == 0) {
+		for (quint32 i = 0; i < imageSectionSize; i += 2) {
+			*out++ = in[i] | (in[i + 1] << 4);
+		}
+	} else {
+		memcpy(out, in, imageSectionSize);
+	}
+
+	return true;
+}
@@ -0,0 +1,39 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef TRANSCODER_H
+#define TRANSCODER_H
+
+#include <QtCore>
+#include "ExtraData.h"
+
+/*
+ * Converts TIM files to TEX files and back, from bytes to bytes.
+ * Palette colors and STP bits follow the rules of the palette files:
+ * 0x0000 is transparent (alpha 0), colors with the STP bit are
+ * semi-transparent (alpha 127). 16-bit pixels are copied as is.
+ * Returns false when the file cannot be converted this way
+ * (24-bit, truncated files, meta data not matching the file...),
+ * TimFile and TexFile must be used instead.
+ */
+class Transcoder
+{
+public:
+	static bool timToTex(const QByteArray &tim, const ExtraData &meta, QByteArray &tex);
+	static bool texToTim(const QByteArray &tex, const ExtraData &meta, QByteArray &tim);
+};
+
+#endif // TRANSCODER_H
@@ -0,0 +1,214 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Vram.h"
+#include "PsColor.h"
+
+Vram::Vram() :
+	_words(VRAM_WIDTH * VRAM_HEIGHT, 0),
+	_view(VRAM_WIDTH, VRAM_HEIGHT, QImage::Format_ARGB32)
+{
+	_view.fill(0);
+}
+
+void Vram::clear()
+{
+	_words.fill(0);
+	_view.fill(0);
+	_used = QRegion();
+	_overlap = QRegion();
+	_dirty = QRegion();
+}
+
+/*
+ * All 16-bit colors, converted once.
+ */
+const QRgb *Vram::colors()
+{
+	static QVector<QRgb> colors;
+	static QMutex mutex;
+	QMutexLocker locker(&mutex);
+
+	if (colors.isEmpty()) {
+		colors.resize(0x10000);
+		for (int i = 0; i < 0x10000; ++i) {
+			colors[i] = PsColor::fromPsColor(quint16(i), true);
+		}
+	}
+
+	return colors.constData();
+}
+
+/*
+ * Copies rect.width() x rect.height() words, the part
+ * outside the VRAM is ignored.
+ */
+bool Vram::upload(const QRect &rect, const quint16 *words, bool *overlap)
+{
+	const QRect bounded = rect & QRect(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+
+	if (bounded.isEmpty()) {
+		return false;
+	}
+
+	for (int y = bounded.top(); y <= bounded.bottom(); ++y) {
+		memcpy(_words.data() + y * VRAM_WIDTH + bounded.left(),
+		       words + (y - rect.top()) * rect.width() + (bounded.left() - rect.left()),
+		       bounded.width() * 2);
+	}
+
+	const QRegion overlapped = _used.intersected(bounded);
+	if (overlap) {
+		*overlap = !overlapped.isEmpty();
+	}
+	_overlap += overlapped;
+	_used += bounded;
+	_dirty += bounded;
+
+	return true;
+}
+
+bool Vram::uploadTim(const QByteArray &data, bool *overlap)
+{
+	const char *constData = data.constData();
+	const quint32 dataSize = data.size();
+	quint32 flag, palSize = 0;
+	quint16 x, y, w, h;
+	bool imageOverlap = false, paletteOverlap = false;
+
+	if (!data.startsWith(QByteArray("\x10\x00\x00\x00", 4)) || dataSize < 8) {
+		return false;
+	}
+
+	memcpy(&flag, constData + 4, 4);
+
+	if ((flag >> 3) & 1) {
+		if (dataSize < 20) {
+			return false;
+		}
+
+		memcpy(&palSize, constData + 8, 4);
+		memcpy(&x, constData + 12, 2);
+		memcpy(&y, constData + 14, 2);
+		memcpy(&w, constData + 16, 2);
+		memcpy(&h, constData + 18, 2);
+
+		if (palSize < 12 || dataSize < 8 + palSize
+		        || quint32(w) * h * 2 > palSize - 12) {
+			return false;
+		}
+
+		upload(QRect(x, y, w, h), (const quint16 *)(constData + 20), &paletteOverlap);
+	}
+
+	if (dataSize < 20 + palSize) {
+		return false;
+	}
+
+	memcpy(&x, constData + 12 + palSize, 2);
+	memcpy(&y, constData + 14 + palSize, 2);
+	memcpy(&w, constData + 16 + palSize, 2);
+	memcpy(&h, constData + 18 + palSize, 2);
+
+	if ((flag & 3) == 3) { // 24-bit: width in 16-bit words
+		w = w * 3 / 2;
+	}
+
+	// Truncated files: only the complete lines
+	if (w > 0) {
+		h = qMin(quint32(h), (dataSize - 20 - palSize) / (w * 2));
+	}
+
+	upload(QRect(x, y, w, h), (const quint16 *)(constData + 20 + palSize), &imageOverlap);
+
+	if (overlap) {
+		*overlap = imageOverlap || paletteOverlap;
+	}
+
+	return true;
+}
+
+/*
+ * VRAM as 16-bit colors, only the modified areas are converted again.
+ */
+const QImage &Vram::view()
+{
+	const QRgb *colors = Vram::colors();
+
+	foreach (const QRect &rect, _dirty.rects()) {
+		for (int y = rect.top(); y <= rect.bottom(); ++y) {
+			QRgb *pixels = (QRgb *)_view.scanLine(y);
+			const quint16 *words = _words.constData() + y * VRAM_WIDTH;
+
+			for (int x = rect.left(); x <= rect.right(); ++x) {
+				pixels[x] = colors[words[x]];
+			}
+		}
+	}
+
+	_dirty = QRegion();
+
+	return _view;
+}
+
+/*
+ * Texture page (64x256 words) as seen by the GPU with this depth,
+ * using the CLUT at clutX, clutY for 4 and 8-bit.
+ * Pages are numbered from left to right (16 per line), then top to bottom.
+ */
+QImage Vram::texturePage(int page, int depth, int clutX, int clutY) const
+{
+	if (page < 0 || page >= 32 || (depth != 4 && depth != 8 && depth != 16)
+	        || clutX < 0 || clutY < 0 || clutY >= VRAM_HEIGHT) {
+		return QImage();
+	}
+
+	const QRgb *colors = Vram::colors();
+	const int pageX = (page % 16) * 64, pageY = (page / 16) * 256,
+	        width = 64 * 16 / depth;
+	QImage image(width, 256, QImage::Format_ARGB32);
+	QRgb clut[256];
+
+	for (int i = 0; i < (depth == 4 ? 16 : 256) && depth < 16; ++i) {
+		clut[i] = clutX + i < VRAM_WIDTH ? colors[word(clutX + i, clutY)] : 0;
+	}
+
+	for (int y = 0; y < 256; ++y) {
+		QRgb *pixels = (QRgb *)image.scanLine(y);
+		const quint16 *words = _words.constData() + (pageY + y) * VRAM_WIDTH + pageX;
+
+		for (int x = 0; x < 64; ++x) {
+			const quint16 w = words[x];
+
+			switch (depth) {
+			case 4:
+				for (int i = 0; i < 4; ++i) {
+					*pixels++ = clut[(w >> (i * 4)) & 0xF];
+				}
+				break;
+			case 8:
+				*pixels++ = clut[w & 0xFF];
+				*pixels++ = clut[w >> 8];
+				break;
+			default:
+				*pixels++ = colors[w];
+				break;
+			}
+		}
+	}
+
+	return image;
+}
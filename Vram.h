@@ -0,0 +1,59 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef VRAM_H
+#define VRAM_H
+
+#include <QtCore>
+#include <QImage>
+#include <QRegion>
+
+#define VRAM_WIDTH	1024
+#define VRAM_HEIGHT	512
+
+/*
+ * PlayStation VRAM: 1024x512 16-bit words.
+ * TIM files are uploaded at their imageX/imageY and paletteX/paletteY
+ * positions, the areas written twice are reported.
+ * Coordinates are in 16-bit words.
+ */
+class Vram
+{
+public:
+	Vram();
+	void clear();
+	bool upload(const QRect &rect, const quint16 *words, bool *overlap = 0);
+	bool uploadTim(const QByteArray &data, bool *overlap = 0);
+	inline quint16 word(int x, int y) const {
+		return _words[y * VRAM_WIDTH + x];
+	}
+	inline const QRegion &usedRegion() const {
+		return _used;
+	}
+	inline const QRegion &overlapRegion() const {
+		return _overlap;
+	}
+	const QImage &view();
+	QImage texturePage(int page, int depth, int clutX, int clutY) const;
+private:
+	static const QRgb *colors();
+
+	QVector<quint16> _words;
+	QRegion _used, _overlap, _dirty;
+	QImage _view;
+};
+
+#endif // VRAM_H
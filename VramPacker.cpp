@@ -0,0 +1,136 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "VramPacker.h"
+#include <algorithm>
+
+#define PAGE_WIDTH	64
+#define PAGE_HEIGHT	256
+#define CLUT_ALIGNMENT	16
+
+VramPacker::VramPacker(const QRect &area) :
+	_area(area & QRect(0, 0, VRAM_WIDTH, VRAM_HEIGHT))
+{
+}
+
+/*
+ * Sizes are in 16-bit words, an empty CLUT size for 16-bit textures.
+ * Returns the texture number.
+ */
+int VramPacker::addTexture(const QSize &imageSize, const QSize &clutSize)
+{
+	Item image, clut;
+
+	image.size = imageSize;
+	image.pos = QPoint(-1, -1);
+	image.isClut = false;
+	clut.size = clutSize;
+	clut.pos = QPoint(-1, -1);
+	clut.isClut = true;
+
+	_images.append(image);
+	_cluts.append(clut);
+
+	return _images.size() - 1;
+}
+
+static bool higherFirst(const QPair<int, int> &item1, const QPair<int, int> &item2)
+{
+	return item1.first > item2.first;
+}
+
+/*
+ * Skyline packing: items are placed by decreasing height,
+ * each one at the lowest position available.
+ */
+bool VramPacker::pack()
+{
+	QList< QPair<int, int> > order; // Height, item (CLUTs after images)
+	bool ok = true;
+
+	_skyline.fill(_area.top(), VRAM_WIDTH);
+
+	for (int i = 0; i < _images.size(); ++i) {
+		order.append(qMakePair(_images.at(i).size.height(), i));
+		if (!_cluts.at(i).size.isEmpty()) {
+			order.append(qMakePair(_cluts.at(i).size.height(), _images.size() + i));
+		}
+	}
+
+	// Stable: same input, same layout
+	std::stable_sort(order.begin(), order.end(), higherFirst);
+
+	for (int i = 0; i < order.size(); ++i) {
+		const int item = order.at(i).second;
+
+		if (!place(item < _images.size() ? _images[item] : _cluts[item - _images.size()])) {
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+bool VramPacker::place(Item &item)
+{
+	const int w = item.size.width(), h = item.size.height(),
+	        alignment = item.isClut ? CLUT_ALIGNMENT : (w > PAGE_WIDTH ? PAGE_WIDTH : 1),
+	        right = _area.left() + _area.width(),
+	        bottom = _area.top() + _area.height();
+	int bestX = -1, bestY = bottom;
+
+	if (w <= 0 || h <= 0) {
+		return false;
+	}
+
+	for (int x = (_area.left() + alignment - 1) / alignment * alignment; x + w <= right; x += alignment) {
+		// Texture coordinates cannot cross a page boundary
+		if (w <= PAGE_WIDTH && x / PAGE_WIDTH != (x + w - 1) / PAGE_WIDTH) {
+			continue;
+		}
+
+		int y = _skyline.at(x);
+		for (int i = x + 1; i < x + w; ++i) {
+			y = qMax(y, _skyline.at(i));
+		}
+
+		if (!item.isClut) {
+			if (h <= PAGE_HEIGHT) {
+				if (y / PAGE_HEIGHT != (y + h - 1) / PAGE_HEIGHT) {
+					y = (y / PAGE_HEIGHT + 1) * PAGE_HEIGHT;
+				}
+			} else if (y % PAGE_HEIGHT != 0) {
+				y = (y / PAGE_HEIGHT + 1) * PAGE_HEIGHT;
+			}
+		}
+
+		if (y + h <= bottom && y < bestY) {
+			bestX = x;
+			bestY = y;
+		}
+	}
+
+	if (bestX < 0) {
+		return false;
+	}
+
+	for (int i = bestX; i < bestX + w; ++i) {
+		_skyline[i] = bestY + h;
+	}
+	item.pos = QPoint(bestX, bestY);
+
+	return true;
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef VRAMPACKER_H
+#define VRAMPACKER_H
+
+#include <QtCore>
+#include "Vram.h"
+
+/*
+ * Assigns non-overlapping VRAM positions to textures and their CLUTs.
+ * Images smaller than a texture page (64x256 words) do not cross
+ * a page boundary, larger ones start on a page boundary.
+ * CLUTs are aligned on 16 words.
+ */
+class VramPacker
+{
+public:
+	explicit VramPacker(const QRect &area = QRect(0, 0, VRAM_WIDTH, VRAM_HEIGHT));
+	int addTexture(const QSize &imageSize, const QSize &clutSize = QSize());
+	bool pack();
+	inline int textureCount() const {
+		return _images.size();
+	}
+	inline QPoint imagePosition(int texture) const {
+		return _images.at(texture).pos;
+	}
+	inline QPoint clutPosition(int texture) const {
+		return _cluts.at(texture).pos;
+	}
+private:
+	struct Item {
+		QSize size;
+		QPoint pos;
+		bool isClut;
+	};
+	bool place(Item &item);
+
+	QRect _area;
+	QVector<int> _skyline;
+	QVector<Item> _images, _cluts;
+};
+
+#endif // VRAMPACKER_H
@@ -0,0 +1,34 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Benchmark.h"
+
+void Benchmark::printHeader()
+{
+	printf("%-32s %11s %12s %12s\n", "benchmark", "size", "ns/pixel", "MB/s");
+}
+
+void Benchmark::print(const QString &name, const QSize &size, qint64 bytes,
+                      double nsPerCall)
+{
+	const qint64 pixels = qint64(size.width()) * size.height();
+
+	printf("%-32s %5dx%-5d %12.3f %12.1f\n", qPrintable(name),
+	       size.width(), size.height(),
+	       pixels > 0 ? nsPerCall / pixels : 0.0,
+	       nsPerCall > 0 ? bytes * 1000.0 / nsPerCall : 0.0);
+	fflush(stdout);
+}
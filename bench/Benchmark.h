@@ -0,0 +1,74 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QtCore>
+#include <algorithm>
+#include <cstdio>
+
+#define BENCHMARK_WARM_UP_NS	50000000 // 50 ms
+#define BENCHMARK_BATCH_NS	20000000 // 20 ms
+#define BENCHMARK_BATCHES	9
+
+/*
+ * Runs a function in batches after a warm up,
+ * and prints the median time per call as ns/pixel and MB/s.
+ */
+class Benchmark
+{
+public:
+	static void printHeader();
+	template<typename Function>
+	static void run(const QString &name, const QSize &size, qint64 bytes,
+	                Function function);
+private:
+	static void print(const QString &name, const QSize &size, qint64 bytes,
+	                  double nsPerCall);
+};
+
+template<typename Function>
+void Benchmark::run(const QString &name, const QSize &size, qint64 bytes,
+                    Function function)
+{
+	QElapsedTimer timer;
+	qint64 calls = 0;
+
+	// Warm up: caches, allocator, and an estimation of the time per call
+	timer.start();
+	do {
+		function();
+		++calls;
+	} while (timer.nsecsElapsed() < BENCHMARK_WARM_UP_NS || calls < 3);
+
+	const qint64 batchSize = qMax(qint64(1), BENCHMARK_BATCH_NS * calls / timer.nsecsElapsed());
+	double times[BENCHMARK_BATCHES];
+
+	for (int batch = 0; batch < BENCHMARK_BATCHES; ++batch) {
+		timer.restart();
+		for (qint64 i = 0; i < batchSize; ++i) {
+			function();
+		}
+		times[batch] = double(timer.nsecsElapsed()) / batchSize;
+	}
+
+	// The median is less sensitive to the other processes than the mean
+	std::sort(times, times + BENCHMARK_BATCHES);
+	print(name, size, bytes, times[BENCHMARK_BATCHES / 2]);
+}
+
+#endif // BENCHMARK_H
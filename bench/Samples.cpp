@@ -0,0 +1,140 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "Samples.h"
+#include "TexFile.h"
+#include "PsColor.h"
+
+Samples::Samples(quint32 seed) :
+	_state(seed == 0 ? 1 : seed)
+{
+}
+
+/*
+ * xorshift32, independent of qrand() and the platform.
+ */
+quint32 Samples::random()
+{
+	_state ^= _state << 13;
+	_state ^= _state >> 17;
+	_state ^= _state << 5;
+	return _state;
+}
+
+quint16 Samples::psColor(int stpPercent)
+{
+	quint16 color = random() & 0x7FFF;
+	if (int(random() % 100) < stpPercent) {
+		color = setPsColorAlphaBit(color, 1);
+	}
+	return color;
+}
+
+/*
+ * Widths in pixels, must be a multiple of 4 for 4-bit
+ * and of 2 for 8-bit.
+ */
+QByteArray Samples::tim(quint8 depth, int width, int height, int nbPalettes,
+                        int stpPercent, quint16 imgX, quint16 imgY,
+                        quint16 palX, quint16 palY)
+{
+	const bool hasPal = depth < 16;
+	const quint32 flag = (quint32(hasPal) << 3) | (depth == 4 ? 0 : depth / 8);
+	const quint16 onePalSize = depth == 4 ? 16 : 256;
+	QByteArray data;
+
+	data.append("\x10\x00\x00\x00", 4);
+	data.append((const char *)&flag, 4);
+
+	if (hasPal) {
+		const quint32 sizePalSection = 12 + nbPalettes * onePalSize * 2;
+		const quint16 palW = onePalSize, palH = quint16(nbPalettes);
+
+		data.append((const char *)&sizePalSection, 4);
+		data.append((const char *)&palX, 2);
+		data.append((const char *)&palY, 2);
+		data.append((const char *)&palW, 2);
+		data.append((const char *)&palH, 2);
+
+		for (int i = 0; i < nbPalettes * onePalSize; ++i) {
+			const quint16 color = psColor(stpPercent);
+			data.append((const char *)&color, 2);
+		}
+	}
+
+	// Like TimFile::open: the width of 24-bit images is in pixels
+	const quint16 w = quint16(depth == 4 ? width / 4 : (depth == 8 ? width / 2 : width)),
+	        h = quint16(height);
+	const quint32 imageSize = depth == 4 ? width / 2 * height : width * (depth / 8) * height,
+	        sizeImgSection = 12 + imageSize;
+
+	data.append((const char *)&sizeImgSection, 4);
+	data.append((const char *)&imgX, 2);
+	data.append((const char *)&imgY, 2);
+	data.append((const char *)&w, 2);
+	data.append((const char *)&h, 2);
+
+	const int start = data.size();
+	data.resize(start + imageSize);
+	uchar *pixels = (uchar *)data.data() + start;
+
+	if (depth == 16) {
+		for (quint32 i = 0; i < imageSize; i += 2) {
+			const quint16 color = psColor(stpPercent);
+			memcpy(pixels + i, &color, 2);
+		}
+	} else {
+		for (quint32 i = 0; i < imageSize; ++i) {
+			pixels[i] = quint8(random());
+		}
+	}
+
+	return data;
+}
+
+QByteArray Samples::tex(quint8 depth, int width, int height, int nbPalettes,
+                        int stpPercent)
+{
+	const bool hasPal = depth < 16;
+	const TexStruct header = TexFile::defaultHeader(TexFile::One, true, depth == 4,
+	                                                hasPal ? nbPalettes : 0, width, height);
+	const int headerSize = sizeof(TexStruct) - 4; // Version 1
+	QByteArray data((const char *)&header, headerSize);
+
+	if (hasPal) {
+		for (quint32 i = 0; i < header.paletteSize; ++i) {
+			const quint16 color = psColor(stpPercent);
+			const QRgb rgb = PsColor::fromPsColor(color, true);
+			// Same rules than TimFile::exportColorTables
+			const char bgra[4] = {
+				char(qBlue(rgb)), char(qGreen(rgb)), char(qRed(rgb)),
+				char(color == 0 ? 0 : (psColorAlphaBit(color) ? 127 : 255))
+			};
+			data.append(bgra, 4);
+		}
+	}
+
+	const quint32 imageSize = width * height * header.bytesPerPixel;
+	const int start = data.size();
+	data.resize(start + imageSize);
+	uchar *pixels = (uchar *)data.data() + start;
+
+	for (quint32 i = 0; i < imageSize; ++i) {
+		pixels[i] = quint8(random() % (depth == 4 ? 16 : 256));
+	}
+
+	return data;
+}
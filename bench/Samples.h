@@ -0,0 +1,41 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+#include <QtCore>
+
+/*
+ * Synthetic TIM and TEX files, the same seed gives the same file.
+ * stpPercent is the ratio of colors with the STP bit set.
+ */
+class Samples
+{
+public:
+	explicit Samples(quint32 seed = 1);
+	QByteArray tim(quint8 depth, int width, int height, int nbPalettes = 1,
+	               int stpPercent = 0, quint16 imgX = 0, quint16 imgY = 0,
+	               quint16 palX = 0, quint16 palY = 0);
+	QByteArray tex(quint8 depth, int width, int height, int nbPalettes = 1,
+	               int stpPercent = 0);
+	quint32 random();
+	quint16 psColor(int stpPercent);
+private:
+	quint32 _state;
+};
+
+#endif // SAMPLES_H
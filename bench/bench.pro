@@ -0,0 +1,39 @@
+QT       += core gui
+
+TARGET = bench
+CONFIG   += console c++14
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+SOURCES += main.cpp \
+    Benchmark.cpp \
+    Samples.cpp \
+    ../TimFile.cpp \
+    ../TextureFile.cpp \
+    ../TexFile.cpp \
+    ../TextureImageFile.cpp \
+    ../TextureRawFile.cpp \
+    ../PsColor.cpp \
+    ../ExtraData.cpp \
+    ../ColorIndexer.cpp \
+    ../Quantizer.cpp \
+    ../Stats.cpp \
+    ../Trace.cpp
+
+HEADERS += \
+    Benchmark.h \
+    Samples.h \
+    ../TimFile.h \
+    ../TextureFile.h \
+    ../TexFile.h \
+    ../TextureImageFile.h \
+    ../TextureRawFile.h \
+    ../PsColor.h \
+    ../ExtraData.h \
+    ../ColorIndexer.h \
+    ../Quantizer.h \
+    ../Stats.h \
+    ../Trace.h
@@ -0,0 +1,158 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtCore>
+#include <QImage>
+#include "Benchmark.h"
+#include "Samples.h"
+#include "TimFile.h"
+#include "TexFile.h"
+#include "PsColor.h"
+
+/*
+ * A sample read with another depth or size would benchmark
+ * a different decoder.
+ */
+static bool openSample(TextureFile &texture, const char *format, const QByteArray &data,
+                       quint8 depth, const QSize &size)
+{
+	if (!texture.open(data) || texture.depth() != depth || texture.image().size() != size) {
+		qWarning() << "Error: invalid" << format << "sample" << depth << "bpp" << size
+		           << "read as" << texture.depth() << "bpp" << texture.image().size();
+		return false;
+	}
+
+	return true;
+}
+
+static bool benchTim(quint8 depth, const QSize &size)
+{
+	Samples samples;
+	const QByteArray data = samples.tim(depth, size.width(), size.height(), 1, 10);
+	TimFile tim;
+
+	if (!openSample(tim, "TIM", data, depth, size)) {
+		return false;
+	}
+
+	Benchmark::run(QString("TimFile::open %1bpp").arg(depth), size, data.size(), [&]() {
+		tim.open(data);
+	});
+
+	Benchmark::run(QString("TimFile::save %1bpp").arg(depth), size, data.size(), [&]() {
+		QByteArray saved;
+		tim.save(saved);
+	});
+
+	return true;
+}
+
+static bool benchTex(quint8 depth, const QSize &size)
+{
+	Samples samples;
+	const QByteArray data = samples.tex(depth, size.width(), size.height(), 1, 10);
+	TexFile tex;
+
+	if (!openSample(tex, "TEX", data, depth, size)) {
+		return false;
+	}
+
+	Benchmark::run(QString("TexFile::open %1bpp").arg(depth), size, data.size(), [&]() {
+		tex.open(data);
+	});
+
+	Benchmark::run(QString("TexFile::save %1bpp").arg(depth), size, data.size(), [&]() {
+		QByteArray saved;
+		tex.save(saved);
+	});
+
+	return true;
+}
+
+static void benchPsColor(const QSize &size)
+{
+	Samples samples;
+	const int count = size.width() * size.height();
+	QVector<quint16> psColors(count);
+	QVector<QRgb> colors(count);
+
+	for (int i = 0; i < count; ++i) {
+		psColors[i] = samples.psColor(10);
+		colors[i] = PsColor::fromPsColor(psColors.at(i), true);
+	}
+
+	Benchmark::run("PsColor::fromPsColor", size, count * 2, [&]() {
+		for (int i = 0; i < count; ++i) {
+			colors[i] = PsColor::fromPsColor(psColors.at(i), true);
+		}
+	});
+
+	Benchmark::run("PsColor::toPsColor", size, count * 4, [&]() {
+		for (int i = 0; i < count; ++i) {
+			psColors[i] = PsColor::toPsColor(colors.at(i));
+		}
+	});
+}
+
+static bool benchPalette(const QSize &size)
+{
+	Samples samples;
+	TimFile tim;
+
+	if (!openSample(tim, "TIM", samples.tim(8, size.width(), size.height(), 16, 10), 8, size)) {
+		return false;
+	}
+
+	const QImage palette = tim.palette();
+	TimFile trueColor = tim;
+	trueColor.convertToTrueColor();
+	trueColor.setPalette(palette);
+
+	Benchmark::run("TextureFile::convertToIndexed", size, size.width() * size.height() * 4, [&]() {
+		TimFile indexed = trueColor;
+		indexed.convertToIndexedFormat(0);
+	});
+
+	Benchmark::run("TextureFile::palette 16x256", size, 16 * 256 * 4, [&]() {
+		tim.palette();
+	});
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QList<QSize> sizes;
+	bool ok = true;
+
+	sizes << QSize(64, 64) << QSize(256, 256) << QSize(1024, 512);
+
+	Benchmark::printHeader();
+
+	foreach (const QSize &size, sizes) {
+		ok = benchTim(4, size) && ok;
+		ok = benchTim(8, size) && ok;
+		ok = benchTim(16, size) && ok;
+		ok = benchTim(24, size) && ok;
+		ok = benchTex(8, size) && ok;
+		ok = benchTex(16, size) && ok;
+		benchPsColor(size);
+		ok = benchPalette(size) && ok;
+	}
+
+	return ok ? 0 : 1;
+}
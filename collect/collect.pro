@@ -0,0 +1,26 @@
+QT       += core gui
+
+TARGET = collect
+CONFIG   += console c++14
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += .. ../tests
+
+SOURCES += main.cpp \
+    ../tests/Collect.cpp \
+    ../TimFile.cpp \
+    ../TextureFile.cpp \
+    ../TexFile.cpp \
+    ../TextureImageFile.cpp \
+    ../TextureRawFile.cpp \
+    ../PsColor.cpp \
+    ../ExtraData.cpp \
+    ../ColorIndexer.cpp \
+    ../Quantizer.cpp \
+    ../Stats.cpp \
+    ../Trace.cpp
+
+HEADERS += \
+    ../tests/Collect.h
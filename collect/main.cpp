@@ -0,0 +1,73 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtCore>
+#include "Collect.h"
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("Vincent Tim collect");
+	QCommandLineParser parser;
+
+	parser.setApplicationDescription("Statistics on the header fields of a directory of textures.");
+	parser.addHelpOption();
+	parser.addOption(QCommandLineOption("format", "File format (tim, *tex*, or an image format).", "format", "tex"));
+	parser.addOption(QCommandLineOption(QStringList() << "r" << "recursive", "Scan the subdirectories."));
+	parser.addOption(QCommandLineOption("threads", "Number of worker threads (default: number of CPU cores).", "threads", "0"));
+	parser.addOption(QCommandLineOption("max-combinations", "Correlation tables with more combinations are only summarized.", "count", "64"));
+	parser.addOption(QCommandLineOption("text", "Only the occurrences of each value, in the format of the data directory."));
+	parser.addOption(QCommandLineOption(QStringList() << "o" << "output", "Output file (default: standard output).", "output", ""));
+	parser.addPositionalArgument("directory", "Directory to scan.");
+	parser.process(a);
+
+	if (parser.positionalArguments().size() != 1) {
+		parser.showHelp(1);
+	}
+
+	Collect collect(parser.positionalArguments().first());
+	QElapsedTimer timer;
+
+	collect.setRecursive(parser.isSet("recursive"));
+	collect.setThreads(qMax(0, parser.value("threads").toInt()));
+	collect.setMaxCombinations(qMax(0, parser.value("max-combinations").toInt()));
+
+	timer.start();
+	collect.collect(parser.value("format"));
+
+	fprintf(stderr, "%d files, %d errors in %.3f s\n",
+	        collect.fileCount(), collect.errorCount(), timer.elapsed() / 1000.0);
+
+	const QByteArray data = parser.isSet("text") ? collect.toText() : collect.toJson();
+	QFile out;
+
+	if (parser.value("output").isEmpty()) {
+		out.open(stdout, QIODevice::WriteOnly);
+	} else {
+		out.setFileName(parser.value("output"));
+		if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(out.fileName()) << out.errorString();
+			return 1;
+		}
+	}
+
+	if (out.write(data) != data.size()) {
+		qWarning() << "Error: Cannot save" << out.errorString();
+		return 1;
+	}
+
+	return collect.errorCount() > 0 ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ArchiveGenerator.h"
+#include "TimFile.h"
+
+#define ARCHIVEGENERATOR_BUFFER_SIZE	1048576
+
+ArchiveGenerator::ArchiveGenerator(quint32 seed) :
+	_samples(seed), _size(64 * 1048576), _timsPerMiB(4), _decoysPerMiB(16),
+	_stpPercent(10)
+{
+}
+
+void ArchiveGenerator::fill(char *data, int size)
+{
+	int i = 0;
+
+	for (; i + 4 <= size; i += 4) {
+		const quint32 value = _samples.random();
+		memcpy(data + i, &value, 4);
+	}
+	for (; i < size; ++i) {
+		data[i] = char(_samples.random());
+	}
+}
+
+/*
+ * 4, 8 or 16-bit, TimFile::findTims does not find 24-bit files.
+ */
+QByteArray ArchiveGenerator::randomTim(QString &description)
+{
+	static const quint8 depths[3] = {4, 8, 16};
+	const quint8 depth = depths[_samples.random() % 3];
+	const int width = 16 + (_samples.random() % 61) * 4, // 16 to 256
+	        height = 16 + _samples.random() % 241,
+	        nbPalettes = depth < 16 ? 1 + _samples.random() % 4 : 0;
+	const quint16 imgX = _samples.random() % 1024, imgY = _samples.random() % 512,
+	        palX = (_samples.random() % 64) * 16, palY = _samples.random() % 512;
+
+	description = QString("%1 %2x%3 %4").arg(depth).arg(width).arg(height).arg(nbPalettes);
+
+	return _samples.tim(depth, width, height, nbPalettes, _stpPercent,
+	                    imgX, imgY, palX, palY);
+}
+
+/*
+ * The magic number with a header rejected by TimFile::findTims.
+ */
+QByteArray ArchiveGenerator::decoy()
+{
+	QByteArray data("\x10\x00\x00\x00", 4);
+	quint32 flag, size;
+	quint16 w = 1 + _samples.random() % 256, h = 1 + _samples.random() % 256;
+
+	switch (_samples.random() % 3) {
+	case 0: // Palette size does not match the palette dimensions
+		flag = 8 + _samples.random() % 2;
+		size = w * h * 2 + 12 + 2;
+		break;
+	case 1: // Unknown flag
+		flag = 4 + _samples.random() % 4;
+		size = w * h * 2 + 12;
+		break;
+	default: // Image size does not match the image dimensions
+		flag = 2;
+		size = w * h * 2 + 12 + 2;
+		break;
+	}
+
+	data.append((const char *)&flag, 4);
+	data.append((const char *)&size, 4);
+	data.append(QByteArray(4, '\0')); // X and Y
+	data.append((const char *)&w, 2);
+	data.append((const char *)&h, 2);
+
+	return data;
+}
+
+bool ArchiveGenerator::generate(const QString &path, const QString &truthPath)
+{
+	QFile archive(path), truth(truthPath);
+
+	if (!archive.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(path) << archive.errorString();
+		return false;
+	}
+
+	if (!truth.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(truthPath) << truth.errorString();
+		return false;
+	}
+
+	const int itemsPerMiB = _timsPerMiB + _decoysPerMiB;
+	// Mean space between two items
+	const qint64 meanGap = itemsPerMiB > 0 ? 1048576 / itemsPerMiB : _size;
+	QByteArray buffer(ARCHIVEGENERATOR_BUFFER_SIZE, '\0');
+	qint64 pos = 0;
+
+	while (pos < _size) {
+		qint64 gap = qMin(qint64(_samples.random() % quint32(2 * meanGap + 1)), _size - pos);
+
+		while (gap > 0) {
+			const int chunkSize = int(qMin(gap, qint64(ARCHIVEGENERATOR_BUFFER_SIZE)));
+			fill(buffer.data(), chunkSize);
+			if (archive.write(buffer.constData(), chunkSize) != chunkSize) {
+				qWarning() << "Error: Cannot write" << QDir::toNativeSeparators(path) << archive.errorString();
+				return false;
+			}
+			pos += chunkSize;
+			gap -= chunkSize;
+		}
+
+		if (pos >= _size || itemsPerMiB == 0) {
+			continue;
+		}
+
+		QByteArray item;
+		QString line;
+
+		if (int(_samples.random() % itemsPerMiB) < _decoysPerMiB) {
+			item = decoy();
+			line = QString("decoy 0x%1 %2\n").arg(pos, 8, 16, QChar('0')).arg(item.size());
+		} else {
+			QString description;
+			item = randomTim(description);
+			line = QString("tim 0x%1 %2 %3\n").arg(pos, 8, 16, QChar('0')).arg(item.size()).arg(description);
+		}
+
+		if (pos + item.size() > _size) {
+			continue; // The end is filled with random bytes
+		}
+
+		if (archive.write(item) != item.size()) {
+			qWarning() << "Error: Cannot write" << QDir::toNativeSeparators(path) << archive.errorString();
+			return false;
+		}
+
+		truth.write(line.toLatin1());
+		pos += item.size();
+	}
+
+	return true;
+}
+
+/*
+ * Compares the "tim" lines of the ground truth with TimFile::findTims.
+ */
+bool ArchiveGenerator::check(const QString &path, const QString &truthPath)
+{
+	QFile archive(path), truth(truthPath);
+
+	if (!archive.open(QIODevice::ReadOnly)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(path) << archive.errorString();
+		return false;
+	}
+
+	if (!truth.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		qWarning() << "Error: cannot open file" << QDir::toNativeSeparators(truthPath) << truth.errorString();
+		return false;
+	}
+
+	QSet<PosSize> expected;
+
+	while (!truth.atEnd()) {
+		const QList<QByteArray> fields = truth.readLine().trimmed().split(' ');
+		if (fields.size() < 3 || fields.first() != "tim") {
+			continue;
+		}
+
+		bool offsetOk, sizeOk;
+		const qint64 offset = fields.at(1).toLongLong(&offsetOk, 0);
+		const int size = fields.at(2).toInt(&sizeOk);
+
+		if (!offsetOk || !sizeOk) {
+			qWarning() << "Error: invalid ground truth line" << fields;
+			return false;
+		}
+
+		expected.insert(PosSize(offset, size));
+	}
+
+	bool ok = true;
+	int found = 0;
+
+	foreach (const PosSize &position, TimFile::findTims(&archive)) {
+		if (expected.remove(position)) {
+			++found;
+		} else {
+			qWarning() << "Error: unexpected TIM at" << position.first << "size" << position.second;
+			ok = false;
+		}
+	}
+
+	foreach (const PosSize &position, expected) {
+		qWarning() << "Error: TIM not found at" << position.first << "size" << position.second;
+		ok = false;
+	}
+
+	printf("%d TIM files found, %d missing\n", found, expected.size());
+
+	return ok;
+}
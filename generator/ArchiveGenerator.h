@@ -0,0 +1,58 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef ARCHIVEGENERATOR_H
+#define ARCHIVEGENERATOR_H
+
+#include <QtCore>
+#include "Samples.h"
+
+/*
+ * Writes a fake archive: random bytes with TIM files at random offsets,
+ * and decoys (the TIM magic number followed by an invalid header).
+ * The ground truth lists every TIM and decoy, one per line:
+ * tim <offset> <size> <depth> <width>x<height> <palettes>
+ * decoy <offset> <size>
+ */
+class ArchiveGenerator
+{
+public:
+	explicit ArchiveGenerator(quint32 seed = 1);
+	inline void setSize(qint64 size) {
+		_size = size;
+	}
+	inline void setTimsPerMiB(int count) {
+		_timsPerMiB = count;
+	}
+	inline void setDecoysPerMiB(int count) {
+		_decoysPerMiB = count;
+	}
+	inline void setStpPercent(int stpPercent) {
+		_stpPercent = stpPercent;
+	}
+	bool generate(const QString &path, const QString &truthPath);
+	static bool check(const QString &path, const QString &truthPath);
+private:
+	QByteArray randomTim(QString &description);
+	QByteArray decoy();
+	void fill(char *data, int size);
+
+	Samples _samples;
+	qint64 _size;
+	int _timsPerMiB, _decoysPerMiB, _stpPercent;
+};
+
+#endif // ARCHIVEGENERATOR_H
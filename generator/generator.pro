@@ -0,0 +1,28 @@
+QT       += core gui
+
+TARGET = generator
+CONFIG   += console c++14
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += .. ../bench
+
+SOURCES += main.cpp \
+    ArchiveGenerator.cpp \
+    ../bench/Samples.cpp \
+    ../TimFile.cpp \
+    ../TextureFile.cpp \
+    ../TexFile.cpp \
+    ../TextureImageFile.cpp \
+    ../TextureRawFile.cpp \
+    ../PsColor.cpp \
+    ../ExtraData.cpp \
+    ../ColorIndexer.cpp \
+    ../Quantizer.cpp \
+    ../Stats.cpp \
+    ../Trace.cpp
+
+HEADERS += \
+    ArchiveGenerator.h \
+    ../bench/Samples.h
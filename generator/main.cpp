@@ -0,0 +1,167 @@
+/****************************************************************************
+ ** Copyright (C) 2009-2012 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtCore>
+#include "ArchiveGenerator.h"
+#include "Samples.h"
+
+/*
+ * Size in bytes, with an optional K, M or G suffix (powers of 1024).
+ */
+static qint64 parseSize(const QString &text, bool *ok)
+{
+	QString number = text.trimmed().toUpper();
+	qint64 factor = 1;
+
+	if (number.endsWith('K')) {
+		factor = Q_INT64_C(1024);
+	} else if (number.endsWith('M')) {
+		factor = Q_INT64_C(1048576);
+	} else if (number.endsWith('G')) {
+		factor = Q_INT64_C(1073741824);
+	}
+
+	if (factor > 1) {
+		number.chop(1);
+	}
+
+	return number.toLongLong(ok) * factor;
+}
+
+static int intValue(const QCommandLineParser &parser, const QString &name, bool *ok)
+{
+	bool valueOk;
+	int value = parser.value(name).toInt(&valueOk);
+	if (!valueOk || value < 0) {
+		qWarning() << "Error: invalid value for" << name << parser.value(name);
+		*ok = false;
+	}
+	return value;
+}
+
+static bool generateTextures(const QString &format, const QString &directory, quint8 depth,
+                             int width, int height, int nbPalettes, int stpPercent,
+                             int count, quint32 seed)
+{
+	Samples samples(seed);
+
+	for (int i = 0; i < count; ++i) {
+		const QByteArray data = format == "tim"
+		        ? samples.tim(depth, width, height, nbPalettes, stpPercent)
+		        : samples.tex(depth, width, height, nbPalettes, stpPercent);
+		QFile f(QString("%1/sample.%2.%3").arg(directory).arg(i).arg(format));
+
+		if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)
+		        || f.write(data) != data.size()) {
+			qWarning() << "Error: Cannot save" << QDir::toNativeSeparators(f.fileName()) << f.errorString();
+			return false;
+		}
+
+		printf("%s\n", qPrintable(QDir::toNativeSeparators(f.fileName())));
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("Vincent Tim generator");
+	QCommandLineParser parser;
+
+	parser.setApplicationDescription("Generates synthetic TIM and TEX files, or fake archives containing TIM files.");
+	parser.addHelpOption();
+	parser.addOption(QCommandLineOption("depth", "Texture depth: 4, 8, 16 or 24 (tim only).", "depth", "8"));
+	parser.addOption(QCommandLineOption("width", "Texture width in pixels.", "width", "256"));
+	parser.addOption(QCommandLineOption("height", "Texture height in pixels.", "height", "256"));
+	parser.addOption(QCommandLineOption("palettes", "Number of palettes.", "palettes", "1"));
+	parser.addOption(QCommandLineOption("stp", "Percentage of colors with the STP bit.", "percent", "10"));
+	parser.addOption(QCommandLineOption("count", "Number of textures.", "count", "1"));
+	parser.addOption(QCommandLineOption("seed", "Seed of the random generator.", "seed", "1"));
+	parser.addOption(QCommandLineOption("size", "Archive size (K, M and G suffixes allowed).", "size", "64M"));
+	parser.addOption(QCommandLineOption("tims", "Archive: TIM files per MiB.", "count", "4"));
+	parser.addOption(QCommandLineOption("decoys", "Archive: decoys per MiB.", "count", "16"));
+	parser.addOption(QCommandLineOption("no-check", "Archive: do not compare the ground truth with TimFile::findTims."));
+	parser.addPositionalArgument("mode", "tim, tex or archive.");
+	parser.addPositionalArgument("output", "Output directory (tim and tex) or archive file.");
+	parser.process(a);
+
+	const QStringList positional = parser.positionalArguments();
+	if (positional.size() != 2) {
+		parser.showHelp(1);
+	}
+
+	const QString mode = positional.first().toLower(), output = positional.last();
+	bool ok = true;
+	const int depth = intValue(parser, "depth", &ok),
+	        width = intValue(parser, "width", &ok),
+	        height = intValue(parser, "height", &ok),
+	        nbPalettes = intValue(parser, "palettes", &ok),
+	        stpPercent = intValue(parser, "stp", &ok),
+	        count = intValue(parser, "count", &ok),
+	        seed = intValue(parser, "seed", &ok),
+	        timsPerMiB = intValue(parser, "tims", &ok),
+	        decoysPerMiB = intValue(parser, "decoys", &ok);
+
+	if (!ok) {
+		return 1;
+	}
+
+	if (mode == "tim" || mode == "tex") {
+		if ((depth != 4 && depth != 8 && depth != 16 && (depth != 24 || mode == "tex"))
+		        || (depth == 4 && width % 4 != 0) || (depth == 8 && width % 2 != 0)
+		        || (depth < 16 && nbPalettes == 0)) {
+			qWarning() << "Error: invalid depth, width or number of palettes";
+			return 1;
+		}
+
+		if (!QDir(output).exists()) {
+			qWarning() << "Error: output directory does not exist" << QDir::toNativeSeparators(output);
+			return 1;
+		}
+
+		return generateTextures(mode, output, depth, width, height, nbPalettes,
+		                        stpPercent, count, seed) ? 0 : 1;
+	} else if (mode == "archive") {
+		const qint64 size = parseSize(parser.value("size"), &ok);
+		if (!ok || size < 0) {
+			qWarning() << "Error: invalid size" << parser.value("size");
+			return 1;
+		}
+
+		ArchiveGenerator generator(seed);
+		generator.setSize(size);
+		generator.setTimsPerMiB(timsPerMiB);
+		generator.setDecoysPerMiB(decoysPerMiB);
+		generator.setStpPercent(stpPercent);
+
+		if (!generator.generate(output, output + ".truth")) {
+			return 1;
+		}
+
+		printf("%s\n", qPrintable(QDir::toNativeSeparators(output)));
+		printf("%s\n", qPrintable(QDir::toNativeSeparators(output + ".truth")));
+
+		if (!parser.isSet("no-check") && !ArchiveGenerator::check(output, output + ".truth")) {
+			return 1;
+		}
+
+		return 0;
+	}
+
+	qWarning() << "Error: unknown mode" << mode;
+	return 1;
+}
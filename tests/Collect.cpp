@@ -16,46 +16,364 @@
  ****************************************************************************/
 #include "Collect.h"
 #include "../TextureFile.h"
+#include "../TexFile.h"
+#include "../TimFile.h"
+
+#define COLLECT_FILES_PER_JOB	256
+
+class CollectJob : public QRunnable
+{
+public:
+	CollectJob(Collect *collect, const QStringList &paths, const QString &format) :
+		_collect(collect), _paths(paths), _format(format)
+	{
+	}
+	void run();
+private:
+	Collect *_collect;
+	QStringList _paths;
+	QString _format;
+};
+
+/*
+ * Histograms of the job, merged once with the others.
+ */
+void CollectJob::run()
+{
+	Collect::Result result;
+	QHash<QString, int> fieldIndexes;
+
+	result.fileCount = 0;
+	result.errorCount = 0;
+
+	foreach (const QString &path, _paths) {
+		QMap<QString, quint32> fields;
+
+		if (!Collect::readFields(path, _format, fields)) {
+			qWarning() << qPrintable(QDir::toNativeSeparators(path)) << "cannot open file";
+			result.errorCount += 1;
+			continue;
+		}
+
+		Collect::Row row;
+		row.values.fill(0, result.fieldNames.size());
+		row.present.resize(result.fieldNames.size());
+
+		QMapIterator<QString, quint32> it(fields);
+		while (it.hasNext()) {
+			it.next();
+			int index = fieldIndexes.value(it.key(), -1);
+
+			if (index < 0) {
+				index = result.fieldNames.size();
+				fieldIndexes.insert(it.key(), index);
+				result.fieldNames.append(it.key());
+				row.values.append(0);
+				row.present.resize(index + 1);
+			}
+
+			row.values[index] = it.value();
+			row.present.setBit(index);
+			result.histograms[it.key()][it.value()] += 1;
+		}
+
+		result.rows.append(row);
+		result.fileCount += 1;
+	}
+
+	_collect->merge(result);
+}
 
 Collect::Collect(const QString &dir) :
-    _dir(dir)
+	_dir(dir), _recursive(false), _threads(0), _maxCombinations(64),
+	_fileCount(0), _errorCount(0)
+{
+}
+
+/*
+ * Only the header of tim and tex files is read, with the checks of
+ * the codecs.
+ */
+bool Collect::readFields(const QString &path, const QString &format,
+                         QMap<QString, quint32> &fields)
+{
+	QFile f(path);
+	ExtraData extraData;
+
+	if (format.compare("tex", Qt::CaseInsensitive) == 0) {
+		TexStruct header;
+
+		if (!f.open(QIODevice::ReadOnly)
+		        || !TexFile::openHeader(f.read(sizeof(TexStruct)), f.size(), header)) {
+			return false;
+		}
+
+		extraData = TexFile::extraDataFromHeader(header);
+	} else if (format.compare("tim", Qt::CaseInsensitive) == 0) {
+		TimFile tim;
+
+		if (!f.open(QIODevice::ReadOnly) || !tim.openHeader(&f)) {
+			return false;
+		}
+
+		extraData = tim.extraData();
+	} else {
+		TextureFile *texture = TextureFile::factory(format);
+		const bool ok = texture->openFromFile(path);
+
+		if (ok) {
+			extraData = texture->extraData();
+		}
+
+		delete texture;
+
+		if (!ok) {
+			return false;
+		}
+	}
+
+	QMapIterator<QString, QVariant> it(extraData.fields());
+	while (it.hasNext()) {
+		it.next();
+		bool isInt;
+		const quint32 value = it.value().toUInt(&isInt);
+		if (!isInt) {
+			qWarning() << "Collect::readFields not an int" << it.key() << it.value();
+		} else {
+			fields.insert(it.key(), value);
+		}
+	}
+
+	return true;
+}
+
+QStringList Collect::files(const QString &format) const
 {
+	QStringList ret;
+	QDirIterator it(_dir.path(), QStringList("*." + format), QDir::Files,
+	                _recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+
+	while (it.hasNext()) {
+		ret.append(it.next());
+	}
+
+	ret.sort();
+
+	return ret;
 }
 
-void Collect::textureData(const QString &format) const
+void Collect::merge(const Result &result)
 {
-	QStringList texFilenames = _dir.entryList(QStringList("*." + format), QDir::Files);
-	QMap<QString, QMap<quint32, int> > occurrences;
-
-	foreach (const QString &texFilename, texFilenames) {
-		TextureFile *tex = TextureFile::factory(format);
-		if (tex->openFromFile(_dir.filePath(texFilename))) {
-			QMap<QString, QVariant> fields = tex->extraData().fields();
-			QMapIterator<QString, QVariant> it(fields);
-			while (it.hasNext()) {
-				it.next();
-				bool ok;
-				quint32 val = it.value().toUInt(&ok);
-				if (!ok) {
-					qDebug() << "Collect::texData not an int" << it.key() << it.value();
-				} else {
-					QMap<quint32, int> counts = occurrences.value(it.key());
-					int count = counts.value(val, 0);
-					counts.insert(val, count + 1);
-					occurrences.insert(it.key(), counts);
+	QMutexLocker locker(&_mutex);
+	QVector<int> globalIndexes;
+
+	foreach (const QString &name, result.fieldNames) {
+		int index = _fieldNames.indexOf(name);
+		if (index < 0) {
+			index = _fieldNames.size();
+			_fieldNames.append(name);
+		}
+		globalIndexes.append(index);
+	}
+
+	QMapIterator<QString, Histogram> it(result.histograms);
+	while (it.hasNext()) {
+		it.next();
+		Histogram &histogram = _histograms[it.key()];
+		QMapIterator<quint32, int> itValues(it.value());
+		while (itValues.hasNext()) {
+			itValues.next();
+			histogram[itValues.key()] += itValues.value();
+		}
+	}
+
+	foreach (const Row &row, result.rows) {
+		Row globalRow;
+		globalRow.values.fill(0, _fieldNames.size());
+		globalRow.present.resize(_fieldNames.size());
+
+		for (int i = 0; i < row.values.size(); ++i) {
+			if (row.present.testBit(i)) {
+				globalRow.values[globalIndexes.at(i)] = row.values.at(i);
+				globalRow.present.setBit(globalIndexes.at(i));
+			}
+		}
+
+		_rows.append(globalRow);
+	}
+
+	_fileCount += result.fileCount;
+	_errorCount += result.errorCount;
+}
+
+/*
+ * Contingency tables of every pair of fields with several values.
+ */
+void Collect::computeCorrelations()
+{
+	QList<int> variables;
+
+	for (int i = 0; i < _fieldNames.size(); ++i) {
+		if (_histograms.value(_fieldNames.at(i)).size() > 1) {
+			variables.append(i);
+		}
+	}
+
+	for (int i = 0; i < variables.size(); ++i) {
+		for (int j = i + 1; j < variables.size(); ++j) {
+			const int index1 = variables.at(i), index2 = variables.at(j);
+			QHash<quint64, int> counts;
+			QHash<quint32, quint32> image1, image2;
+			Correlation correlation;
+
+			correlation.field1 = _fieldNames.at(index1);
+			correlation.field2 = _fieldNames.at(index2);
+			correlation.determines = true;
+			correlation.determinedBy = true;
+
+			foreach (const Row &row, _rows) {
+				if (index1 >= row.present.size() || index2 >= row.present.size()
+				        || !row.present.testBit(index1) || !row.present.testBit(index2)) {
+					continue;
+				}
+
+				const quint32 value1 = row.values.at(index1), value2 = row.values.at(index2);
+				counts[(quint64(value1) << 32) | value2] += 1;
+
+				if (image1.contains(value1) && image1.value(value1) != value2) {
+					correlation.determines = false;
+				}
+				image1.insert(value1, value2);
+				if (image2.contains(value2) && image2.value(value2) != value1) {
+					correlation.determinedBy = false;
 				}
+				image2.insert(value2, value1);
 			}
-		} else {
-			qDebug() << texFilename << "cannot open file";
+
+			correlation.combinationCount = counts.size();
+
+			if (counts.size() <= _maxCombinations) {
+				QHashIterator<quint64, int> it(counts);
+				while (it.hasNext()) {
+					it.next();
+					correlation.combinations.insert(qMakePair(quint32(it.key() >> 32), quint32(it.key())),
+					                                it.value());
+				}
+			}
+
+			_correlations.append(correlation);
 		}
-		delete tex;
 	}
+}
+
+bool Collect::collect(const QString &format)
+{
+	const QStringList paths = files(format);
+	QThreadPool pool;
+
+	_format = format;
+	_fileCount = _errorCount = 0;
+	_fieldNames.clear();
+	_histograms.clear();
+	_rows.clear();
+	_correlations.clear();
+
+	if (_threads > 0) {
+		pool.setMaxThreadCount(_threads);
+	}
+
+	for (int i = 0; i < paths.size(); i += COLLECT_FILES_PER_JOB) {
+		pool.start(new CollectJob(this, paths.mid(i, COLLECT_FILES_PER_JOB), format));
+	}
+
+	pool.waitForDone();
+
+	computeCorrelations();
+
+	return _errorCount == 0;
+}
+
+/*
+ * Same format than the files in the data directory.
+ */
+QByteArray Collect::toText() const
+{
+	QByteArray ret;
+
+	QMapIterator<QString, Histogram> it(_histograms);
+	while (it.hasNext()) {
+		it.next();
+		ret.append(QString("\"%1\"\n").arg(it.key()).toUtf8());
+
+		QMapIterator<quint32, int> itValues(it.value());
+		while (itValues.hasNext()) {
+			itValues.next();
+			ret.append(QString("\t %1 -> x %2\n").arg(itValues.key()).arg(itValues.value()).toUtf8());
+		}
+	}
+
+	return ret;
+}
+
+QByteArray Collect::toJson() const
+{
+	QJsonObject root, fields;
+	QJsonArray correlations;
+
+	QMapIterator<QString, Histogram> it(_histograms);
+	while (it.hasNext()) {
+		it.next();
+		QJsonObject values;
+		QMapIterator<quint32, int> itValues(it.value());
+		while (itValues.hasNext()) {
+			itValues.next();
+			values[QString::number(itValues.key())] = itValues.value();
+		}
+		fields[it.key()] = values;
+	}
+
+	foreach (const Correlation &correlation, _correlations) {
+		QJsonObject object;
+		QJsonArray combinations;
+
+		QMapIterator<QPair<quint32, quint32>, int> itCombinations(correlation.combinations);
+		while (itCombinations.hasNext()) {
+			itCombinations.next();
+			QJsonArray combination;
+			combination.append(double(itCombinations.key().first));
+			combination.append(double(itCombinations.key().second));
+			combination.append(itCombinations.value());
+			combinations.append(combination);
+		}
+
+		object["fields"] = QJsonArray() << correlation.field1 << correlation.field2;
+		object["determines"] = correlation.determines;
+		object["determinedBy"] = correlation.determinedBy;
+		object["combinationCount"] = correlation.combinationCount;
+		if (!correlation.combinations.isEmpty()) {
+			object["combinations"] = combinations;
+		}
+		correlations.append(object);
+	}
+
+	root["format"] = _format;
+	root["files"] = _fileCount;
+	root["errors"] = _errorCount;
+	root["fields"] = fields;
+	root["correlations"] = correlations;
+
+	return QJsonDocument(root).toJson();
+}
+
+void Collect::textureData(const QString &format)
+{
+	collect(format);
 
-	QMapIterator<QString, QMap<quint32, int> > it(occurrences);
+	QMapIterator<QString, Histogram> it(_histograms);
 	while (it.hasNext()) {
 		it.next();
 		const QString &name = it.key();
-		const QMap<quint32, int> &values = it.value();
+		const Histogram &values = it.value();
 
 		qDebug() << name;
 
@@ -19,13 +19,81 @@
 
 #include <QtCore>
 
+/*
+ * Statistics on the header fields of a corpus of textures:
+ * number of occurrences of each value, and correlation tables
+ * between the fields that are not constant.
+ * Only the headers of tim and tex files are read, other formats
+ * are opened entirely. Files are scanned in a thread pool.
+ */
 class Collect
 {
 public:
-	Collect(const QString &dir);
-	void textureData(const QString &format) const;
+	typedef QMap<quint32, int> Histogram;
+	struct Correlation {
+		QString field1, field2;
+		// field1 value -> only one field2 value (and vice versa)
+		bool determines, determinedBy;
+		int combinationCount;
+		QMap<QPair<quint32, quint32>, int> combinations;
+	};
+
+	explicit Collect(const QString &dir);
+	inline void setRecursive(bool recursive) {
+		_recursive = recursive;
+	}
+	inline void setThreads(int threads) {
+		_threads = threads;
+	}
+	// Combinations listed in correlation tables, beyond only the summary
+	inline void setMaxCombinations(int maxCombinations) {
+		_maxCombinations = maxCombinations;
+	}
+	bool collect(const QString &format);
+	void textureData(const QString &format);
+	inline int fileCount() const {
+		return _fileCount;
+	}
+	inline int errorCount() const {
+		return _errorCount;
+	}
+	inline const QMap<QString, Histogram> &histograms() const {
+		return _histograms;
+	}
+	inline const QList<Correlation> &correlations() const {
+		return _correlations;
+	}
+	QByteArray toText() const;
+	QByteArray toJson() const;
+
+	// Used by the jobs
+	struct Row {
+		QVector<quint32> values;
+		QBitArray present;
+	};
+	struct Result {
+		QStringList fieldNames;
+		QMap<QString, Histogram> histograms;
+		QList<Row> rows;
+		int fileCount, errorCount;
+	};
+	void merge(const Result &result);
+	static bool readFields(const QString &path, const QString &format,
+	                       QMap<QString, quint32> &fields);
 private:
+	QStringList files(const QString &format) const;
+	void computeCorrelations();
+
 	QDir _dir;
+	QString _format;
+	bool _recursive;
+	int _threads, _maxCombinations;
+	int _fileCount, _errorCount;
+	QStringList _fieldNames;
+	QMap<QString, Histogram> _histograms;
+	QList<Row> _rows;
+	QList<Correlation> _correlations;
+	QMutex _mutex;
 };
 
 #endif // COLLECT_H
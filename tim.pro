@@ -1,7 +1,7 @@
-QT       += core gui
+QT       += core gui network
 
 TARGET = tim
-CONFIG   += console
+CONFIG   += console c++14
 CONFIG   -= app_bundle
 
 TEMPLATE = app
@@ -13,8 +13,24 @@ SOURCES += main.cpp \
     TextureFile.cpp \
     TexFile.cpp \
     TextureImageFile.cpp \
+    TextureRawFile.cpp \
     PsColor.cpp \
     ExtraData.cpp \
+    Hash.cpp \
+    Stats.cpp \
+    Trace.cpp \
+    Deduplicator.cpp \
+    ColorIndexer.cpp \
+    Quantizer.cpp \
+    Transcoder.cpp \
+    Vram.cpp \
+    VramPacker.cpp \
+    BuildDatabase.cpp \
+    Converter.cpp \
+    Daemon.cpp \
+    TextureCache.cpp \
+    JobsFile.cpp \
+    RoundTrip.cpp \
     tests/Collect.cpp
 
 HEADERS += \
@@ -23,8 +39,24 @@ HEADERS += \
     TextureFile.h \
     TexFile.h \
     TextureImageFile.h \
+    TextureRawFile.h \
     PsColor.h \
     ExtraData.h \
+    Hash.h \
+    Stats.h \
+    Trace.h \
+    Deduplicator.h \
+    ColorIndexer.h \
+    Quantizer.h \
+    Transcoder.h \
+    Vram.h \
+    VramPacker.h \
+    BuildDatabase.h \
+    Converter.h \
+    Daemon.h \
+    TextureCache.h \
+    JobsFile.h \
+    RoundTrip.h \
     tests/Collect.h
 
 OTHER_FILES += README.md